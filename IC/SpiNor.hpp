@@ -0,0 +1,818 @@
+/**
+ * This file is part of m library.
+ *
+ * m library is free software: you can redistribute it and/or modify
+ * it under the terms of the MIT License. See the LICENSE file in the
+ * project root for more information.
+ *
+ * Copyright (c) 2025 Max Melekesov <max.melekesov@gmail.com>
+ */
+
+#ifndef SPINOR_H
+#define SPINOR_H
+
+#include <IFlashMemory.hpp>
+#include <IIO_Sync.hpp>
+#include <IMemory.hpp>
+#include <IPin.hpp>
+#include <ITime.hpp>
+#include <Ms.hpp>
+#include <Timeout.hpp>
+#include <Timer.hpp>
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <optional>
+#include <span>
+
+namespace m::ic {
+// Generic SPI NOR flash. init() reads JEDEC ID (0x9F) and the SFDP basic
+// parameter table to set size, erase types, read commands, 4-byte
+// addressing and the quad enable method, then picks the fastest read
+// mode short of Quad. Quad writes the non-volatile QE bit, which takes
+// over the /WP and /HOLD pins, so it is only entered by
+// setReadMode(ReadMode::Quad). Chips without SFDP need setConfig().
+// Needs 4K erase and 256 byte pages, as nearly every SPI NOR part has.
+// Queue_Size - max number of pending async operations
+template <typename TimeUnit, std::size_t Queue_Size = 4>
+class SpiNor : public m::ifc::IMemory {
+ public:
+  using type = TimeUnit;
+
+  enum class OpStatus : uint8_t { Queued, Running, Done, Failed };
+
+  // Normal - 0x03, lowest max clock. Fast - 0x0B with dummy clocks.
+  // Dual/Quad - 1-1-2/1-1-4, data phase on 2/4 lines, needs the SPI backend
+  // to support setDataLines(). Quad also sets the non-volatile QE bit if
+  // needed, the board must not drive /WP or /HOLD then.
+  enum class ReadMode : uint8_t { Normal, Fast, Dual, Quad };
+
+  // How the QE bit is set, JESD216 QER field
+  enum class QuadEnable : uint8_t {
+    None,
+    Status1_Bit6,       // 0x05 / 0x01 one byte
+    Status2_Bit1,       // 0x05, 0x35 / 0x01 two bytes
+    Status2_Bit1_Wr31,  // 0x35 / 0x31
+  };
+
+  struct EraseType {
+    uint32_t size;  // 0 - not supported
+    uint8_t command;
+  };
+
+  struct ReadCommand {
+    uint8_t command;  // 0 - not supported
+    uint8_t dummy;    // Dummy bytes after address
+  };
+
+  struct Config {
+    std::size_t size;
+    uint8_t addr_bytes;
+    std::array<EraseType, 4> erase;   // Ascending size
+    std::array<ReadCommand, 4> read;  // By ReadMode
+    QuadEnable quad_enable;
+    uint8_t suspend;  // 0 - not supported
+    uint8_t resume;
+    uint16_t resume_to_suspend_us;  // tRS, min time before next suspend
+  };
+
+  // Scratch keeps pages of a partially written sector across its erase.
+  // Use a static buffer or an arena, not the stack.
+  SpiNor(m::ifc::IIO_Sync<Ms<type>>& spi, m::ifc::mcu::IPin& cs_pin,
+         m::ifc::ITime<Ms<type>>& time, std::span<uint8_t, 4'096> scratch)
+      : spi_(spi),
+        cs_pin_(cs_pin),
+        time_(time),
+        timeout_(time_),
+        timer_(time_),
+        resume_timer_(time_),
+        scratch_(scratch) {}
+
+  // Reads JEDEC ID and SFDP, chips without SFDP keep the current config
+  bool init() {
+    std::array<uint8_t, 3> id;
+    if (!readRaw(Commands::Read_Id, 0, 0, id)) return false;
+    jedec_id_ = (id[0] << 16) | (id[1] << 8) | id[2];
+
+    if (auto config = readSfdp()) config_ = config.value();
+    if (config_.size == 0 || config_.erase[0].size != 4'096) return false;
+
+    if (config_.addr_bytes == 4 && !sendCommand(Commands::Enter_4B)) {
+      return false;
+    }
+
+    for (auto mode : {ReadMode::Dual, ReadMode::Fast}) {
+      if (setReadMode(mode)) return true;
+    }
+    return setReadMode(ReadMode::Normal);
+  }
+
+  // Manufacturer, memory type, capacity
+  uint32_t getJedecId() { return jedec_id_; }
+
+  void setConfig(Config const& config) { config_ = config; }
+  Config const& getConfig() { return config_; }
+
+  std::size_t size() override { return config_.size; }
+
+  bool setReadMode(ReadMode mode) {
+    if (config_.read[uint8_t(mode)].command == 0) return false;
+    if (auto lines = dataLines(mode); lines != 1) {
+      if (!spi_.setDataLines(lines)) return false;
+      spi_.setDataLines(1);
+    }
+    if (mode == ReadMode::Quad && !setQuadEnable()) return false;
+
+    read_mode_ = mode;
+    return true;
+  }
+
+  ReadMode getReadMode() { return read_mode_; }
+
+  bool read(std::size_t addr, std::span<uint8_t> data) override {
+    auto read_cmd = config_.read[uint8_t(read_mode_)];
+    std::array<uint8_t, 13> cmd{};
+    cmd[0] = read_cmd.command;
+    auto header = std::span(cmd).first(
+        putAddress(cmd, addr, config_.addr_bytes) + read_cmd.dummy);
+    auto lines = dataLines(read_mode_);
+
+    cs_pin_.write(1);
+    auto wr_ok = spi_.write(
+        header, Ms<type>{header.size() * 1'000 / spi_.getBaudrate() + 10});
+    auto rd_ok = false;
+    if (lines == 1 || spi_.setDataLines(lines)) {
+      rd_ok = spi_.read(
+          data, Ms<type>{data.size() * 1'000 / spi_.getBaudrate() + 10});
+    }
+    if (lines != 1) spi_.setDataLines(1);
+    cs_pin_.write(0);
+
+    return wr_ok && rd_ok;
+  }
+
+  bool write(std::size_t addr, std::span<uint8_t const> data) override {
+    while (data.size() != 0) {
+      // Whole aligned blocks are erased with one command if needed
+      if (auto size = eraseUnit(addr, data.size()); size > 4'096) {
+        if (!writeUnit(addr, data.first(size))) return false;
+
+        addr += size;
+        data = data.subspan(size);
+        continue;
+      }
+
+      auto offset = addr & 0xF'FF;
+      auto size = std::min<std::size_t>(4'096 - offset, data.size());
+      if (!writeSector(addr - offset, offset, data.first(size))) return false;
+
+      addr += size;
+      data = data.subspan(size);
+    }
+
+    return true;
+  }
+
+  // Raw page program without erase, any size and alignment
+  bool program(std::size_t addr, std::span<uint8_t const> data) {
+    while (data.size() != 0) {
+      auto size = std::min<std::size_t>(256 - (addr & 0xFF), data.size());
+      if (!writeBlock(addr, data.first(size))) return false;
+
+      addr += size;
+      data = data.subspan(size);
+    }
+
+    return true;
+  }
+
+  // Addr and size aligned to 4K, erased with the largest units that fit
+  bool erase(std::size_t addr, std::size_t size) {
+    if (addr % 4'096 != 0 || size % 4'096 != 0) return false;
+
+    while (size != 0) {
+      auto unit = eraseUnit(addr, size);
+      if (unit == 0) return false;
+      if (!startErase(addr, unit) || !waitReady(eraseTime(unit))) {
+        return false;
+      }
+
+      addr += unit;
+      size -= unit;
+    }
+
+    return true;
+  }
+
+  // Same chip as IFlashMemory: write() only programs, erase is explicit
+  m::ifc::IFlashMemory& flash() { return flash_; }
+
+  // ##################################################
+  // Async operations, executed by handle() one SPI step per call.
+  // Data must stay valid until the operation is done. Blocking read() and
+  // write() must not be called while operations are pending.
+  // Submit returns operation id, nullopt if the queue is full.
+  // ##################################################
+
+  std::optional<uint32_t> submitRead(uint32_t addr, std::span<uint8_t> data) {
+    return submit(Op{OpType::Read, OpStatus::Queued, addr, data.size(),
+                     data.data(), nullptr});
+  }
+
+  // Raw page program, no erase, any size and alignment
+  std::optional<uint32_t> submitProgram(uint32_t addr,
+                                        std::span<uint8_t const> data) {
+    return submit(Op{OpType::Program, OpStatus::Queued, addr, data.size(),
+                     nullptr, data.data()});
+  }
+
+  // Addr and size aligned to 4K, erased with the largest units that fit
+  std::optional<uint32_t> submitErase(uint32_t addr, std::size_t size) {
+    if (addr % 4'096 != 0 || size % 4'096 != 0) return std::nullopt;
+    return submit(
+        Op{OpType::Erase, OpStatus::Queued, addr, size, nullptr, nullptr});
+  }
+
+  // Nullopt if the id is unknown or its slot was already reused
+  std::optional<OpStatus> getStatus(uint32_t id) {
+    if (id >= tail_ || tail_ - id > Queue_Size) return std::nullopt;
+    return ops_[id % Queue_Size].status;
+  }
+
+  bool idle() { return head_ == tail_; }
+
+  // Read allowed to preempt a running async erase or program. The
+  // operation is suspended for the read and resumed after, fails if the
+  // chip has no suspend. Data in the block being erased or the page being
+  // programmed is not valid while suspended. A suspend waits for tRS
+  // after the previous resume, so back to back reads do not starve the
+  // operation.
+  bool readUrgent(uint32_t addr, std::span<uint8_t> data) {
+    if (!busy_) return read(addr, data);
+    if (config_.suspend == 0) return false;
+
+    // The ms tick only tells that a resume was recent, tRS itself is
+    // waited out with status reads of 16 SPI clocks each
+    if (resume_timer_.running() && !resume_timer_.timeOver()) {
+      auto polls = uint64_t{config_.resume_to_suspend_us} *
+                       spi_.getBaudrate() / 16 / 1'000'000 + 1;
+      for (uint64_t i = 0; i < polls; ++i) {
+        auto res = writeInProgress();
+        if (!res) return false;
+        if (!res.value()) return read(addr, data);
+      }
+    }
+
+    if (!sendCommand(Commands{config_.suspend})) return false;
+    auto rd_ok = waitReady(Ms<type>{1}) && read(addr, data);
+    auto resume_ok = sendCommand(Commands{config_.resume});
+    // Wait limit restarts, suspended time must not fail the operation
+    timer_.reset();
+    // One more ms for the tick granularity
+    resume_timer_.restart(
+        Ms<type>{(config_.resume_to_suspend_us + 999u) / 1'000 + 1});
+
+    return rd_ok && resume_ok;
+  }
+
+  void handle() {
+    if (head_ == tail_) return;
+    auto& op = ops_[head_ % Queue_Size];
+    op.status = OpStatus::Running;
+
+    if (busy_) {
+      auto res = writeInProgress();
+      if (!res || (res.value() && timer_.timeOver())) {
+        finish(OpStatus::Failed);
+      } else if (!res.value()) {
+        busy_ = false;
+        timer_.stop();
+        if (op.size == 0) finish(OpStatus::Done);
+      }
+      return;
+    }
+
+    std::size_t size = 0;
+    bool ok = false;
+    switch (op.type) {
+      case OpType::Read:
+        size = std::min<std::size_t>(op.size, 256);
+        ok = read(op.addr, std::span(op.rd_data, size));
+        op.rd_data += size;
+        break;
+      case OpType::Program:
+        size = std::min<std::size_t>(256 - (op.addr & 0xFF), op.size);
+        ok = startBlock(op.addr, std::span(op.wr_data, size));
+        op.wr_data += size;
+        timer_.restart(Ms<type>{5});
+        break;
+      case OpType::Erase:
+        size = eraseUnit(op.addr, op.size);
+        ok = startErase(op.addr, size);
+        timer_.restart(eraseTime(size));
+        break;
+    }
+    op.addr += size;
+    op.size -= size;
+
+    if (!ok) {
+      finish(OpStatus::Failed);
+    } else if (op.type != OpType::Read) {
+      busy_ = true;
+    } else if (op.size == 0) {
+      finish(OpStatus::Done);
+    }
+  }
+
+ private:
+  m::ifc::IIO_Sync<Ms<type>>& spi_;
+  m::ifc::mcu::IPin& cs_pin_;
+  m::ifc::ITime<Ms<type>>& time_;
+  m::Timeout<Ms<type>> timeout_;
+  m::Timer<Ms<type>> timer_;
+  m::Timer<Ms<type>> resume_timer_;
+
+  class Flash : public m::ifc::IFlashMemory {
+   public:
+    Flash(SpiNor& chip) : chip_(chip) {}
+
+    std::size_t size() override { return chip_.size(); }
+
+    bool erase(std::size_t addr, uint32_t size) override {
+      return chip_.idle() && chip_.erase(addr, size);
+    }
+
+    bool write(std::size_t addr, std::span<uint8_t const> data) override {
+      return chip_.idle() && chip_.program(addr, data);
+    }
+
+    // Suspends a running erase for the read
+    bool read(std::size_t addr, std::span<uint8_t> data) override {
+      return chip_.readUrgent(addr, data);
+    }
+
+    // Goes through the async queue, eraseDone() runs handle()
+    bool startErase(std::size_t addr, uint32_t size) override {
+      erase_id_ = chip_.submitErase(addr, size);
+      return erase_id_.has_value();
+    }
+
+    std::optional<bool> eraseDone() override {
+      if (!erase_id_) return std::nullopt;
+      chip_.handle();
+      auto status = chip_.getStatus(erase_id_.value());
+      if (!status || status.value() == OpStatus::Failed) return std::nullopt;
+      return status.value() == OpStatus::Done;
+    }
+
+   private:
+    SpiNor& chip_;
+    std::optional<uint32_t> erase_id_;
+  };
+
+  Flash flash_{*this};
+  std::span<uint8_t, 4'096> const scratch_;
+
+  Config config_{};
+  uint32_t jedec_id_ = 0;
+
+  enum class OpType : uint8_t { Read, Program, Erase };
+
+  struct Op {
+    OpType type;
+    OpStatus status;
+    uint32_t addr;
+    std::size_t size;
+    uint8_t* rd_data;
+    uint8_t const* wr_data;
+  };
+
+  std::array<Op, Queue_Size> ops_;
+  uint32_t head_ = 0;
+  uint32_t tail_ = 0;
+  bool busy_ = false;
+
+  std::optional<uint32_t> submit(Op const& op) {
+    if (op.size == 0 || tail_ - head_ == Queue_Size) return std::nullopt;
+    ops_[tail_ % Queue_Size] = op;
+    return tail_++;
+  }
+
+  void finish(OpStatus status) {
+    ops_[head_ % Queue_Size].status = status;
+    ++head_;
+    busy_ = false;
+    timer_.stop();
+  }
+
+  enum class Commands : uint8_t {
+    Write_Status = 0x01,
+    Page_Prog = 0x02,
+    Write_Disable = 0x04,
+    Read_Status = 0x05,
+    Write_Enable = 0x06,
+    Write_Status_1 = 0x31,
+    Read_Status_1 = 0x35,
+    Read_Sfdp = 0x5A,
+    Read_Id = 0x9F,
+    Enter_4B = 0xB7,
+    Erase_Chip = 0xC7,
+
+  };
+
+  static constexpr uint32_t Sfdp_Signature = 0x50'44'46'53;
+
+  ReadMode read_mode_ = ReadMode::Fast;
+
+  static uint8_t dataLines(ReadMode mode) {
+    if (mode == ReadMode::Dual) return 2;
+    if (mode == ReadMode::Quad) return 4;
+    return 1;
+  }
+
+  // QE bit is non-volatile, written only once per chip
+  bool setQuadEnable() {
+    auto status = readRegister(Commands::Read_Status);
+    auto status_1 = readRegister(Commands::Read_Status_1);
+    if (!status || !status_1) return false;
+
+    std::array<uint8_t, 3> cmd{static_cast<uint8_t>(Commands::Write_Status),
+                               status.value(), status_1.value()};
+    std::size_t cmd_size = 2;
+    switch (config_.quad_enable) {
+      case QuadEnable::None:
+        return true;
+      case QuadEnable::Status1_Bit6:
+        if (status.value() & 0x40) return true;
+        cmd[1] |= 0x40;
+        break;
+      case QuadEnable::Status2_Bit1:
+        if (status_1.value() & 0x02) return true;
+        cmd[2] |= 0x02;
+        cmd_size = 3;
+        break;
+      case QuadEnable::Status2_Bit1_Wr31:
+        if (status_1.value() & 0x02) return true;
+        cmd[0] = static_cast<uint8_t>(Commands::Write_Status_1);
+        cmd[1] = status_1.value() | 0x02;
+        break;
+    }
+
+    if (!setWriteMode(1)) return false;
+
+    cs_pin_.write(1);
+    auto wr_ok = spi_.write(
+        std::span(cmd).first(cmd_size),
+        Ms<type>{cmd_size * 1'000 / spi_.getBaudrate() + 10});
+    cs_pin_.write(0);
+
+    return wr_ok && waitReady(Ms<type>{50});
+  }
+
+  std::optional<uint8_t> readRegister(Commands command) {
+    std::array<uint8_t, 1> value;
+    if (!readRaw(command, 0, 0, value)) return std::nullopt;
+    return value[0];
+  }
+
+  // Register, ID or SFDP read. SFDP has 3 address bytes and 8 dummy clocks.
+  bool readRaw(Commands command, uint32_t addr, uint8_t addr_bytes,
+              std::span<uint8_t> data) {
+    std::array<uint8_t, 5> cmd{static_cast<uint8_t>(command)};
+    auto header = std::span(cmd).first(
+        putAddress(cmd, addr, addr_bytes) + (addr_bytes != 0 ? 1 : 0));
+
+    cs_pin_.write(1);
+    auto wr_ok = spi_.write(
+        header, Ms<type>{header.size() * 1'000 / spi_.getBaudrate() + 10});
+    auto rd_ok = spi_.read(
+        data, Ms<type>{data.size() * 1'000 / spi_.getBaudrate() + 10});
+    cs_pin_.write(0);
+
+    return wr_ok && rd_ok;
+  }
+
+  // Writes address after the command byte, returns header size
+  static std::size_t putAddress(std::span<uint8_t> cmd, uint32_t addr,
+                                uint8_t addr_bytes) {
+    for (uint8_t i = 0; i < addr_bytes; ++i) {
+      cmd[1 + i] = addr >> (8 * (addr_bytes - 1 - i));
+    }
+    return 1 + addr_bytes;
+  }
+
+  // Basic flash parameter table, JESD216
+  std::optional<Config> readSfdp() {
+    std::array<uint8_t, 16> header;
+    if (!readRaw(Commands::Read_Sfdp, 0, 3, header)) return std::nullopt;
+    uint32_t signature = header[0] | (header[1] << 8) | (header[2] << 16) |
+                         (uint32_t(header[3]) << 24);
+    // First parameter header is always the basic table
+    if (signature != Sfdp_Signature || header[8] != 0x00) return std::nullopt;
+
+    std::array<uint8_t, 16 * 4> raw;
+    auto dwords = std::min<std::size_t>(header[11], 16);
+    if (dwords < 9) return std::nullopt;
+    uint32_t table = header[12] | (header[13] << 8) | (header[14] << 16);
+    if (!readRaw(Commands::Read_Sfdp, table, 3,
+                std::span(raw).first(dwords * 4))) {
+      return std::nullopt;
+    }
+
+    std::array<uint32_t, 16> dw{};
+    for (std::size_t i = 0; i < dwords; ++i) {
+      dw[i] = raw[i * 4] | (raw[i * 4 + 1] << 8) | (raw[i * 4 + 2] << 16) |
+              (uint32_t(raw[i * 4 + 3]) << 24);
+    }
+
+    Config config{};
+    auto bits = dw[1] & 0x7F'FF'FF'FF;
+    auto size_bits = dw[1] & 0x80'00'00'00 ? uint64_t{1} << bits
+                                           : uint64_t{bits} + 1;
+    config.size = size_bits / 8;
+
+    config.addr_bytes = ((dw[0] >> 17) & 0x03) == 0 ? 3 : 4;
+    if (config.size <= 16 * 1024 * 1024 && ((dw[0] >> 17) & 0x03) == 1) {
+      config.addr_bytes = 3;
+    }
+
+    std::size_t erase_num = 0;
+    for (std::size_t i = 0; i < 4; ++i) {
+      auto field = dw[7 + i / 2] >> (16 * (i % 2));
+      if (auto n = field & 0xFF; n != 0) {
+        config.erase[erase_num++] = {uint32_t{1} << n,
+                                     static_cast<uint8_t>(field >> 8)};
+      }
+    }
+    std::sort(config.erase.begin(), config.erase.begin() + erase_num,
+              [](auto& a, auto& b) { return a.size < b.size; });
+
+    config.read[uint8_t(ReadMode::Normal)] = {0x03, 0};
+    config.read[uint8_t(ReadMode::Fast)] = {0x0B, 1};
+    if (dw[0] & (1 << 16)) {
+      config.read[uint8_t(ReadMode::Dual)] = readCommand(dw[3]);
+    }
+    if (dw[0] & (1 << 22)) {
+      config.read[uint8_t(ReadMode::Quad)] = readCommand(dw[2] >> 16);
+    }
+
+    config.quad_enable = QuadEnable::Status2_Bit1_Wr31;
+    if (dwords >= 15) {
+      switch ((dw[14] >> 20) & 0x07) {
+        case 0:
+          config.quad_enable = QuadEnable::None;
+          break;
+        case 2:
+          config.quad_enable = QuadEnable::Status1_Bit6;
+          break;
+        case 1:
+        case 4:
+        case 5:
+          config.quad_enable = QuadEnable::Status2_Bit1;
+          break;
+        case 3:
+          config.read[uint8_t(ReadMode::Quad)] = {0, 0};
+          break;
+      }
+    }
+
+    if (dwords >= 13 && !(dw[11] & 0x80'00'00'00)) {
+      config.suspend = dw[12] >> 24;
+      config.resume = dw[12] >> 16;
+      // Erase and program resume to suspend intervals, (count + 1) * 64 us
+      auto erase_trs = ((dw[11] >> 20) & 0x0F) + 1;
+      auto program_trs = ((dw[11] >> 9) & 0x0F) + 1;
+      config.resume_to_suspend_us = std::max(erase_trs, program_trs) * 64;
+    }
+
+    return config;
+  }
+
+  // Dummy and mode clocks of 1-1-N reads are sent as whole bytes
+  static ReadCommand readCommand(uint32_t field) {
+    uint8_t clocks = (field & 0x1F) + ((field >> 5) & 0x07);
+    if (clocks % 8 != 0) return ReadCommand{0, 0};
+    return ReadCommand{static_cast<uint8_t>(field >> 8),
+                       static_cast<uint8_t>(clocks / 8)};
+  }
+
+  bool setWriteMode(bool value) {
+    return sendCommand(value ? Commands::Write_Enable
+                             : Commands::Write_Disable);
+  }
+
+  bool sendCommand(Commands command) {
+    std::array<uint8_t, 1> cmd{static_cast<uint8_t>(command)};
+
+    cs_pin_.write(1);
+    auto wr_ok =
+        spi_.write(cmd, Ms<type>{cmd.size() * 1'000 / spi_.getBaudrate() + 10});
+    cs_pin_.write(0);
+
+    return wr_ok;
+  }
+
+  // Largest erase unit that starts at addr and fits in size, 0 if none
+  std::size_t eraseUnit(std::size_t addr, std::size_t size) {
+    if (addr == 0 && size >= this->size()) return this->size();
+    for (auto it = config_.erase.rbegin(); it != config_.erase.rend(); ++it) {
+      if (it->size != 0 && addr % it->size == 0 && size >= it->size) {
+        return it->size;
+      }
+    }
+    return 0;
+  }
+
+  // Data covers the whole erase unit, so nothing has to be read back
+  bool writeUnit(uint32_t addr, std::span<uint8_t const> data) {
+    bool need_erase = false;
+    if (!programChanged(addr, data, need_erase)) return false;
+    if (!need_erase) return true;
+
+    if (!erase(addr, data.size())) return false;
+    return writePages(addr, data);
+  }
+
+  // Sector is erased only if some bit has to go from 0 to 1
+  bool writeSector(uint32_t addr, std::size_t offset,
+                   std::span<uint8_t const> data) {
+    bool need_erase = false;
+    if (!programChanged(addr + offset, data, need_erase)) return false;
+    if (!need_erase) return true;
+
+    return rewriteSector(addr, offset, data);
+  }
+
+  // Only pages holding data outside the written range are kept in RAM
+  // across the erase, the rest is programmed from data directly
+  bool rewriteSector(uint32_t addr, std::size_t offset,
+                     std::span<uint8_t const> data) {
+    std::array<uint8_t, 256> page_buf;
+    auto end = offset + data.size();
+
+    uint16_t keep = 0;
+    for (std::size_t page = 0; page < 4'096; page += 256) {
+      if (offset <= page && page + 256 <= end) continue;
+      if (!read(addr + page, page_buf)) return false;
+      for (std::size_t i = 0; i < 256; ++i) {
+        if ((page + i < offset || page + i >= end) && page_buf[i] != 0xFF) {
+          keep |= 1 << (page / 256);
+          break;
+        }
+      }
+    }
+
+    for (std::size_t page = 0, slot = 0; page < 4'096; page += 256) {
+      if (keep & (1 << (page / 256))) {
+        if (!read(addr + page, scratch_.subspan(slot++ * 256, 256))) {
+          return false;
+        }
+      }
+    }
+
+    if (!erase(addr, 4'096)) return false;
+
+    for (std::size_t page = 0, slot = 0; page < 4'096; page += 256) {
+      auto first = std::clamp(offset, page, page + 256);
+      auto last = std::clamp(end, page, page + 256);
+      auto part = data.subspan(first - offset, last - first);
+
+      if (keep & (1 << (page / 256))) {
+        auto kept_page = scratch_.subspan(slot++ * 256, 256);
+        std::ranges::copy(part, kept_page.begin() + (first - page));
+        if (!writePages(addr + page, kept_page)) return false;
+      } else if (!part.empty() &&
+                 !std::ranges::all_of(part, [](auto v) { return v == 0xFF; }) &&
+                 !writeBlock(addr + first, part)) {
+        return false;
+      }
+    }
+
+    return true;
+  }
+
+  // Programs only changed bytes of every 256 byte page.
+  // Stops with need_erase if some bit has to go from 0 to 1.
+  bool programChanged(uint32_t addr, std::span<uint8_t const> data,
+                      bool& need_erase) {
+    std::array<uint8_t, 256> old_buf;
+    while (data.size() != 0) {
+      auto size = std::min<std::size_t>(256 - (addr & 0xFF), data.size());
+      auto old = std::span(old_buf).first(size);
+      if (!read(addr, old)) return false;
+
+      for (std::size_t i = 0; i < size; ++i) {
+        if ((old[i] & data[i]) != data[i]) {
+          need_erase = true;
+          return true;
+        }
+      }
+
+      auto first = std::ranges::mismatch(old, data.first(size)).in1 -
+                   old.begin();
+      if (first != static_cast<std::ptrdiff_t>(size)) {
+        auto last = size;
+        while (old[last - 1] == data[last - 1]) --last;
+        if (!writeBlock(addr + first, data.subspan(first, last - first))) {
+          return false;
+        }
+      }
+
+      addr += size;
+      data = data.subspan(size);
+    }
+
+    return true;
+  }
+
+  // Addr must be start of 256 byte page, 0xXX'XX'XX'00,
+  // size multiple of 256, blank pages are skipped
+  bool writePages(uint32_t addr, std::span<uint8_t const> data) {
+    while (data.size() != 0) {
+      auto page = data.first(256);
+      if (!std::ranges::all_of(page, [](auto v) { return v == 0xFF; }) &&
+          !writeBlock(addr, page)) {
+        return false;
+      }
+      addr += 256;
+      data = data.subspan(256);
+    }
+
+    return true;
+  }
+
+  // Max size - 256 bytes
+  // Data must not cross 256 byte page boundary, 0xXX'XX'XX'00
+  bool writeBlock(uint32_t addr, std::span<uint8_t const> data) {
+    return startBlock(addr, data) && waitReady(Ms<type>{5});
+  }
+
+  bool startBlock(uint32_t addr, std::span<uint8_t const> data) {
+    if (!setWriteMode(1)) return false;
+
+    std::array<uint8_t, 5> cmd{static_cast<uint8_t>(Commands::Page_Prog)};
+    auto header =
+        std::span(cmd).first(putAddress(cmd, addr, config_.addr_bytes));
+
+    cs_pin_.write(1);
+    auto wr_ok = spi_.write(
+        header, Ms<type>{header.size() * 1'000 / spi_.getBaudrate() + 10});
+    auto wrd_ok = spi_.write(
+        data, Ms<type>{data.size() * 1'000 / spi_.getBaudrate() + 10});
+    cs_pin_.write(0);
+
+    return wr_ok && wrd_ok;
+  }
+
+  bool waitReady(Ms<type> max_time) {
+    return timeout_.execWithTimeout(
+        [&]() -> bool {
+          auto res = writeInProgress();
+          return !res.value_or(false);
+        },
+        max_time);
+  }
+
+  std::optional<bool> writeInProgress() {
+    auto status = readRegister(Commands::Read_Status);
+    if (!status) return std::nullopt;
+    return status.value() & uint8_t(0x01);
+  }
+
+  bool startErase(uint32_t addr, std::size_t size) {
+    if (!setWriteMode(1)) return false;
+
+    std::array<uint8_t, 5> cmd{static_cast<uint8_t>(Commands::Erase_Chip)};
+    auto cmd_size = std::size_t{1};
+    if (size != this->size()) {
+      auto erase_type = std::ranges::find_if(
+          config_.erase, [&](auto& erase) { return erase.size == size; });
+      if (erase_type == config_.erase.end()) return false;
+      cmd[0] = erase_type->command;
+      cmd_size = putAddress(cmd, addr, config_.addr_bytes);
+    }
+
+    cs_pin_.write(1);
+    auto wr_ok = spi_.write(
+        std::span(cmd).first(cmd_size),
+        Ms<type>{cmd_size * 1'000 / spi_.getBaudrate() + 10});
+    cs_pin_.write(0);
+
+    return wr_ok;
+  }
+
+  // Chip erase scaled from 100 s per 16 MB
+  Ms<type> eraseTime(std::size_t size) {
+    if (size == this->size()) {
+      return Ms<type>{100'000 * std::max<std::size_t>(size >> 24, 1)};
+    }
+    if (size > 4'096) {
+      return Ms<type>{2'000 * std::max<std::size_t>(size >> 16, 1)};
+    }
+    return Ms<type>{1'000};
+  }
+};
+}  // namespace m::ic
+
+#endif  // SPINOR_H
\ No newline at end of file
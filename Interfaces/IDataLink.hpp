@@ -22,6 +22,9 @@ class IDataLink {
 
   virtual bool startReceive(std::span<uint8_t> rx_buf) = 0;
   virtual std::optional<uint32_t> getRxPacketSize() = 0;
+  // Bytes have arrived since startReceive(), a cheap check without side
+  // effects. Links that cannot tell always report true.
+  virtual bool rxPending() { return true; }
 
   virtual bool startTransmit(std::span<uint8_t> tx_buf) = 0;
   virtual std::optional<bool> transmitDone() = 0;
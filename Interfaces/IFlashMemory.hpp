@@ -12,6 +12,7 @@
 #define IFLASHMEMORY_H
 
 #include <cstdint>
+#include <optional>
 #include <span>
 
 namespace m::ifc {
@@ -23,6 +24,14 @@ class IFlashMemory {
   virtual bool erase(std::size_t addr, uint32_t size) = 0;
   virtual bool write(std::size_t addr, std::span<uint8_t const> data) = 0;
   virtual bool read(std::size_t addr, std::span<uint8_t> data) = 0;
+
+  // Starts an erase without waiting for it, eraseDone() polls it.
+  // By default the erase is blocking and is done on return.
+  virtual bool startErase(std::size_t addr, uint32_t size) {
+    return erase(addr, size);
+  }
+  // True once the erase is over, nullopt if it failed
+  virtual std::optional<bool> eraseDone() { return true; }
 };
 }  // namespace m::ifc
 
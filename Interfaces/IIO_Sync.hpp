@@ -28,6 +28,8 @@ class IIO_Sync {
 
   virtual uint32_t getBaudrate() = 0;
   virtual bool setBaudrate(uint32_t baud) { return false; }
+  // Data lines for the following transfers (1, 2 or 4), e.g. dual/quad SPI
+  virtual bool setDataLines(uint8_t lines) { return lines == 1; }
 };
 }  // namespace m::ifc
 
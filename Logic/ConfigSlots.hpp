@@ -0,0 +1,144 @@
+/**
+ * This file is part of m library.
+ *
+ * m library is free software: you can redistribute it and/or modify
+ * it under the terms of the MIT License. See the LICENSE file in the
+ * project root for more information.
+ *
+ * Copyright (c) 2025 Max Melekesov <max.melekesov@gmail.com>
+ */
+
+#ifndef CONFIGSLOTS_H
+#define CONFIGSLOTS_H
+
+#include <HashFAQ6.hpp>
+#include <IMemory.hpp>
+#include <TSerDes.hpp>
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <optional>
+#include <span>
+
+namespace m {
+
+// Configuration blob kept in two slots, the halves of an IMemory rounded
+// down to whole sectors. Each slot starts with a header {magic,
+// generation, size, data HashFAQ6, header HashFAQ6}. write() goes to the
+// inactive slot, data first and then the header with the next
+// generation, so power loss at any point leaves the previous config valid.
+// init() reads one header per slot and picks the newest valid one, read()
+// checks the data hash and falls back to the other slot if it does not
+// match.
+// Sector_Size - erase sector of the memory, slots never share one. Use 1
+// for memories written without erase.
+template <std::size_t Sector_Size = 4'096>
+class ConfigSlots {
+ public:
+  static constexpr std::size_t Header_Size = 20;
+
+  ConfigSlots(ifc::IMemory& mem)
+      : mem_(mem), slot_size_(mem.size() / 2 / Sector_Size * Sector_Size) {}
+
+  // Returns false if no slot holds a valid config or the memory is
+  // smaller than two sectors
+  bool init() {
+    if (slot_size_ == 0) return false;
+    for (std::size_t i = 0; i < 2; ++i) headers_[i] = readHeader(i);
+
+    auto& first = headers_[0];
+    auto& second = headers_[1];
+    if (!first && !second) return false;
+    active_ = !first || (second && second->gen > first->gen) ? 1 : 0;
+    return true;
+  }
+
+  // Copies the config into data, returns its size. Data smaller than the
+  // active config is an error, not a reason to take the older one.
+  std::optional<std::size_t> read(std::span<uint8_t> data) {
+    for (auto slot : {active_, 1 - active_}) {
+      auto& header = headers_[slot];
+      if (!header) continue;
+      if (header->size > data.size()) return std::nullopt;
+
+      auto blob = data.first(header->size);
+      if (!mem_.read(slotAddress(slot) + Header_Size, blob) ||
+          !hash_.check(blob, header->hash)) {
+        continue;
+      }
+
+      active_ = slot;
+      return header->size;
+    }
+
+    return std::nullopt;
+  }
+
+  // Writes the config into the inactive slot and makes it active
+  bool write(std::span<uint8_t const> data) {
+    if (slot_size_ == 0 || data.size() > capacity()) return false;
+
+    auto slot = 1 - active_;
+    auto gen = headers_[active_] ? headers_[active_]->gen + 1 : 0;
+    if (headers_[slot]) gen = std::max(gen, headers_[slot]->gen + 1);
+    headers_[slot].reset();
+
+    if (!mem_.write(slotAddress(slot) + Header_Size, data)) return false;
+
+    Header header{gen, uint32_t(data.size()), hash_.calc(data)};
+    std::array<uint8_t, Header_Size> raw;
+    m::serialize(raw, Magic, header.gen, header.size, header.hash);
+    auto hash = hash_.calc(std::span(raw).first(Header_Size - 4));
+    std::ranges::copy(hash, raw.end() - hash.size());
+    if (!mem_.write(slotAddress(slot), raw)) return false;
+
+    headers_[slot] = header;
+    active_ = slot;
+    return true;
+  }
+
+  std::size_t capacity() {
+    return slot_size_ > Header_Size ? slot_size_ - Header_Size : 0;
+  }
+
+  // Generation of the active config
+  std::optional<uint32_t> getGeneration() {
+    if (!headers_[active_]) return std::nullopt;
+    return headers_[active_]->gen;
+  }
+
+ private:
+  static constexpr uint32_t Magic = 0x43'46'47'31;
+
+  struct Header {
+    uint32_t gen;
+    uint32_t size;
+    HashFAQ6::Hash hash;
+  };
+
+  ifc::IMemory& mem_;
+  std::size_t const slot_size_;
+  HashFAQ6 hash_;
+
+  std::array<std::optional<Header>, 2> headers_;
+  std::size_t active_ = 0;
+
+  std::size_t slotAddress(std::size_t slot) { return slot * slot_size_; }
+
+  std::optional<Header> readHeader(std::size_t slot) {
+    std::array<uint8_t, Header_Size> raw;
+    if (!mem_.read(slotAddress(slot), raw)) return std::nullopt;
+    auto [magic, gen, size, data_hash, hash] =
+        m::deserialize<uint32_t, uint32_t, uint32_t, HashFAQ6::Hash,
+                       HashFAQ6::Hash>(raw);
+
+    if (magic != Magic || size > capacity() ||
+        !hash_.check(std::span(raw).first(Header_Size - 4), hash)) {
+      return std::nullopt;
+    }
+    return Header{gen, size, data_hash};
+  }
+};
+}  // namespace m
+
+#endif  // CONFIGSLOTS_H
@@ -0,0 +1,314 @@
+/**
+ * This file is part of m library.
+ *
+ * m library is free software: you can redistribute it and/or modify
+ * it under the terms of the MIT License. See the LICENSE file in the
+ * project root for more information.
+ *
+ * Copyright (c) 2025 Max Melekesov <max.melekesov@gmail.com>
+ */
+
+#ifndef FLASHFTL_H
+#define FLASHFTL_H
+
+#include <HashFAQ6.hpp>
+#include <IFlashMemory.hpp>
+#include <IMemory.hpp>
+#include <TSerDes.hpp>
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <optional>
+#include <span>
+
+namespace m {
+
+// Wear-leveling IMemory over Sectors_Num sectors of flash.
+// Every write of a logical sector goes to a fresh physical sector, the
+// free sector with the fewest erases is taken. Each physical sector
+// starts with a header:
+//   {magic, erase count, ~erase count} - programmed right after erase
+//   {alloc}                            - programmed before the data
+//   {logical, seq, HashFAQ6}           - programmed after the data
+// so a write torn by power loss leaves the old copy in place. init()
+// reads only the headers. Stale sectors are erased by handle() in the
+// background with IFlashMemory::startErase(), or by write() when no free
+// sector is left.
+// Spare_Sectors - physical sectors not visible as logical ones, at least 1
+template <std::size_t Sectors_Num, std::size_t Spare_Sectors = 2,
+          std::size_t Sector_Size = 4'096>
+class FlashFtl : public ifc::IMemory {
+ public:
+  static constexpr std::size_t Header_Size = 32;
+  static constexpr std::size_t Data_Size = Sector_Size - Header_Size;
+  static constexpr std::size_t Logical_Sectors = Sectors_Num - Spare_Sectors;
+
+  static_assert(Spare_Sectors >= 1 && Sectors_Num > Spare_Sectors,
+                "Wrong number of sectors");
+
+  FlashFtl(ifc::IFlashMemory& flash, std::size_t offset)
+      : flash_(flash), offset_(offset) {}
+
+  // Rebuilds the map from sector headers
+  bool init() {
+    map_.fill(None);
+    seq_ = 0;
+
+    for (std::size_t p = 0; p < Sectors_Num; ++p) {
+      std::array<uint8_t, Header_Size> raw;
+      if (!flash_.read(sectorAddress(p), raw)) return false;
+      auto [magic, count, count_inv, alloc, logical, seq] =
+          m::deserialize<uint32_t, uint32_t, uint32_t, uint32_t, uint32_t,
+                         uint32_t>(raw);
+
+      states_[p] = State::Stale;
+      erase_counts_[p] = 0;
+      if (magic != Magic || count != ~count_inv) continue;
+
+      erase_counts_[p] = count;
+      if (alloc == Free_Mark) {
+        states_[p] = State::Free;
+        continue;
+      }
+
+      HashFAQ6::Hash hash;
+      std::copy_n(raw.begin() + Hash_Offset, hash.size(), hash.begin());
+      if (logical >= Logical_Sectors ||
+          !hash_.check(std::span(raw).subspan(4, Hash_Offset - 4), hash)) {
+        continue;
+      }
+
+      seq_ = std::max(seq_, seq + 1);
+      if (map_[logical] != None) {
+        if (seqs_[logical] > seq) continue;
+        states_[map_[logical]] = State::Stale;
+      }
+      map_[logical] = p;
+      seqs_[logical] = seq;
+      states_[p] = State::Used;
+    }
+
+    return true;
+  }
+
+  std::size_t size() override { return Logical_Sectors * Data_Size; }
+
+  bool read(std::size_t addr, std::span<uint8_t> data) override {
+    while (data.size() != 0) {
+      auto logical = addr / Data_Size;
+      auto offset = addr % Data_Size;
+      auto size = std::min(Data_Size - offset, data.size());
+      if (logical >= Logical_Sectors) return false;
+
+      if (map_[logical] == None) {
+        std::fill_n(data.begin(), size, 0xFF);
+      } else if (!flash_.read(dataAddress(map_[logical]) + offset,
+                              data.first(size))) {
+        return false;
+      }
+
+      addr += size;
+      data = data.subspan(size);
+    }
+
+    return true;
+  }
+
+  bool write(std::size_t addr, std::span<uint8_t const> data) override {
+    host_bytes_ += data.size();
+    if (erasing_ && !finishErase()) return false;
+
+    while (data.size() != 0) {
+      auto logical = addr / Data_Size;
+      auto offset = addr % Data_Size;
+      auto size = std::min(Data_Size - offset, data.size());
+      if (logical >= Logical_Sectors) return false;
+      if (!writeSector(logical, offset, data.first(size))) return false;
+
+      addr += size;
+      data = data.subspan(size);
+    }
+
+    return true;
+  }
+
+  // Starts the erase of one stale sector, the following calls poll it
+  // and stamp the sector free when done
+  bool handle() {
+    if (erasing_) {
+      auto done = flash_.eraseDone();
+      if (!done) {
+        erasing_.reset();
+        return false;
+      }
+      if (!done.value()) return true;
+
+      auto sector = erasing_.value();
+      erasing_.reset();
+      return stamp(sector);
+    }
+
+    if (auto p = pick(State::Stale)) {
+      if (!flash_.startErase(sectorAddress(p.value()), Sector_Size)) {
+        return false;
+      }
+      erasing_ = p;
+    }
+    return true;
+  }
+
+  // Bytes passed to write() and bytes programmed into flash with headers
+  uint64_t getHostBytes() { return host_bytes_; }
+  uint64_t getFlashBytes() { return flash_bytes_; }
+
+  uint32_t getEraseCount(std::size_t sector) { return erase_counts_[sector]; }
+
+  // Max minus min erase count of all sectors
+  uint32_t getEraseSpread() {
+    auto [min, max] = std::ranges::minmax(erase_counts_);
+    return max - min;
+  }
+
+ private:
+  static constexpr uint32_t Magic = 0x46'54'4C'31;
+  static constexpr uint32_t Free_Mark = 0xFF'FF'FF'FF;
+  static constexpr std::size_t Alloc_Offset = 12;
+  static constexpr std::size_t Commit_Offset = 16;
+  static constexpr std::size_t Hash_Offset = 24;
+  static constexpr uint16_t None = 0xFF'FF;
+
+  static_assert(Sectors_Num < None, "Too many sectors");
+
+  enum class State : uint8_t { Stale, Free, Used };
+
+  ifc::IFlashMemory& flash_;
+  std::size_t const offset_;
+  HashFAQ6 hash_;
+
+  std::array<uint16_t, Logical_Sectors> map_;
+  std::array<uint32_t, Logical_Sectors> seqs_;
+  std::array<State, Sectors_Num> states_{};
+  std::array<uint32_t, Sectors_Num> erase_counts_{};
+  uint32_t seq_ = 0;
+
+  // Stale sector erased in the background by handle()
+  std::optional<std::size_t> erasing_;
+
+  uint64_t host_bytes_ = 0;
+  uint64_t flash_bytes_ = 0;
+
+  std::size_t sectorAddress(std::size_t sector) {
+    return offset_ + sector * Sector_Size;
+  }
+
+  std::size_t dataAddress(std::size_t sector) {
+    return sectorAddress(sector) + Header_Size;
+  }
+
+  // Sector in state with the fewest erases
+  std::optional<std::size_t> pick(State state) {
+    std::optional<std::size_t> best;
+    for (std::size_t p = 0; p < Sectors_Num; ++p) {
+      if (states_[p] == state &&
+          (!best || erase_counts_[p] < erase_counts_[best.value()])) {
+        best = p;
+      }
+    }
+    return best;
+  }
+
+  bool eraseSector(std::size_t sector) {
+    return flash_.erase(sectorAddress(sector), Sector_Size) && stamp(sector);
+  }
+
+  // Waits for the erase started by handle()
+  bool finishErase() {
+    auto done = flash_.eraseDone();
+    while (done && !done.value()) done = flash_.eraseDone();
+
+    auto sector = erasing_.value();
+    erasing_.reset();
+    return done && stamp(sector);
+  }
+
+  // Programs the erase count into a just erased sector
+  bool stamp(std::size_t sector) {
+    states_[sector] = State::Stale;
+
+    auto count = erase_counts_[sector] + 1;
+    std::array<uint8_t, 12> stamp;
+    m::serialize(stamp, Magic, count, ~count);
+    if (!program(sectorAddress(sector), stamp)) return false;
+
+    erase_counts_[sector] = count;
+    states_[sector] = State::Free;
+    return true;
+  }
+
+  bool program(std::size_t addr, std::span<uint8_t const> data) {
+    flash_bytes_ += data.size();
+    return flash_.write(addr, data);
+  }
+
+  // Copies the old data around the written range page by page
+  bool writeSector(std::size_t logical, std::size_t offset,
+                   std::span<uint8_t const> data) {
+    auto target = pick(State::Free);
+    if (!target) {
+      auto stale = pick(State::Stale);
+      if (!stale || !eraseSector(stale.value())) return false;
+      target = stale;
+    }
+    auto p = target.value();
+    states_[p] = State::Stale;
+
+    std::array<uint8_t, 4> alloc{};
+    if (!program(sectorAddress(p) + Alloc_Offset, alloc)) return false;
+
+    auto old = map_[logical];
+    std::array<uint8_t, 256> chunk;
+    for (std::size_t pos = 0; pos < Data_Size; pos += chunk.size()) {
+      auto part =
+          std::span(chunk).first(std::min(chunk.size(), Data_Size - pos));
+      auto first = std::clamp(offset, pos, pos + part.size());
+      auto last = std::clamp(offset + data.size(), pos, pos + part.size());
+
+      if (last - first != part.size()) {
+        if (old == None) {
+          std::ranges::fill(part, 0xFF);
+        } else if (!flash_.read(dataAddress(old) + pos, part)) {
+          return false;
+        }
+      }
+      // The chunk may lie outside the written range
+      if (first != last) {
+        std::copy(data.begin() + (first - offset),
+                  data.begin() + (last - offset),
+                  part.begin() + (first - pos));
+      }
+
+      if (!std::ranges::all_of(part, [](auto v) { return v == 0xFF; }) &&
+          !program(dataAddress(p) + pos, part)) {
+        return false;
+      }
+    }
+
+    std::array<uint8_t, Hash_Offset - 4> fields;
+    auto count = erase_counts_[p];
+    m::serialize(fields, count, ~count, uint32_t{0}, uint32_t(logical), seq_);
+    auto hash = hash_.calc(fields);
+
+    std::array<uint8_t, 12> commit;
+    m::serialize(commit, uint32_t(logical), seq_, hash);
+    if (!program(sectorAddress(p) + Commit_Offset, commit)) return false;
+
+    if (old != None) states_[old] = State::Stale;
+    map_[logical] = p;
+    seqs_[logical] = seq_++;
+    states_[p] = State::Used;
+    return true;
+  }
+};
+}  // namespace m
+
+#endif  // FLASHFTL_H
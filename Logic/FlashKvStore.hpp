@@ -0,0 +1,304 @@
+/**
+ * This file is part of m library.
+ *
+ * m library is free software: you can redistribute it and/or modify
+ * it under the terms of the MIT License. See the LICENSE file in the
+ * project root for more information.
+ *
+ * Copyright (c) 2025 Max Melekesov <max.melekesov@gmail.com>
+ */
+
+#ifndef FLASHKVSTORE_H
+#define FLASHKVSTORE_H
+
+#include <HashFAQ6.hpp>
+#include <IFlashMemory.hpp>
+#include <TSerDes.hpp>
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstdint>
+#include <optional>
+#include <span>
+
+namespace m {
+
+// Key-value store in a region of flash (EEPROM emulation). The region is
+// split into two banks, records {key, size, value, HashFAQ6} are appended
+// to the active bank, so an update is one small program. When the bank is
+// full, live records are copied to the other bank, which becomes active
+// once its header {magic, seq, HashFAQ6} is programmed. A compaction or
+// record torn by power loss leaves the previous values in place.
+// init() scans the active bank once and builds a RAM hash index, lookups
+// do not touch flash until the value is read.
+// Max_Keys  - number of distinct keys, removed keys count until compaction
+// Max_Value - largest value size in bytes
+template <std::size_t Max_Keys, std::size_t Max_Value = 64,
+          std::size_t Sector_Size = 4'096>
+class FlashKvStore {
+ public:
+  using key_type = uint16_t;
+
+  // Region must hold at least two sectors
+  FlashKvStore(ifc::IFlashMemory& flash, std::size_t offset, std::size_t size)
+      : flash_(flash),
+        offset_(offset),
+        bank_size_(size / 2 / Sector_Size * Sector_Size) {}
+
+  // Picks the newest valid bank and indexes it, formats an empty region
+  bool init() {
+    if (bank_size_ == 0) return false;
+
+    auto first = readBankHeader(0);
+    auto second = readBankHeader(1);
+    if (!first && !second) {
+      bank_ = 0;
+      seq_ = 0;
+      if (!flash_.erase(bankAddress(0), bank_size_) ||
+          !writeBankHeader(0, seq_)) {
+        return false;
+      }
+    } else if (!second || (first && first.value() > second.value())) {
+      bank_ = 0;
+      seq_ = first.value();
+    } else {
+      bank_ = 1;
+      seq_ = second.value();
+    }
+
+    return scan();
+  }
+
+  // Copies the value into data, returns its size
+  std::optional<std::size_t> read(key_type key, std::span<uint8_t> data) {
+    auto slot = find(key);
+    if (!slot || slots_[slot.value()].size == 0) return std::nullopt;
+
+    auto& entry = slots_[slot.value()];
+    auto size = std::min<std::size_t>(entry.size, data.size());
+    if (!flash_.read(bankAddress(bank_) + entry.pos + Record_Header,
+                     data.first(size))) {
+      return std::nullopt;
+    }
+    return entry.size;
+  }
+
+  // Writing the stored value again costs only a read
+  bool write(key_type key, std::span<uint8_t const> data) {
+    if (key == Erased_Key || data.size() == 0 || data.size() > Max_Value) {
+      return false;
+    }
+
+    std::array<uint8_t, Max_Value> stored;
+    auto size = read(key, stored);
+    if (size == data.size() &&
+        std::ranges::equal(std::span(stored).first(data.size()), data)) {
+      return true;
+    }
+    return append(key, data);
+  }
+
+  bool remove(key_type key) {
+    auto slot = find(key);
+    if (!slot || slots_[slot.value()].size == 0) return true;
+    return append(key, {});
+  }
+
+  // Copies live records to the other bank and switches to it, the index
+  // is rebuilt from the new bank so removed keys are dropped
+  bool compact() {
+    auto target = 1 - bank_;
+    if (!flash_.erase(bankAddress(target), bank_size_)) return false;
+
+    std::array<uint8_t, Record_Max> record;
+    auto pos = Bank_Header;
+    for (auto& entry : slots_) {
+      if (entry.key == Erased_Key || entry.size == 0) continue;
+
+      auto span = std::span(record).first(Record_Header + entry.size + 4);
+      if (!flash_.read(bankAddress(bank_) + entry.pos, span) ||
+          !flash_.write(bankAddress(target) + pos, span)) {
+        return false;
+      }
+      pos += span.size();
+    }
+
+    if (!writeBankHeader(target, seq_ + 1)) return false;
+    bank_ = target;
+    ++seq_;
+    return scan();
+  }
+
+  // Bytes taken in the active bank and the bank size
+  std::size_t getUsed() { return pos_; }
+  std::size_t getBankSize() { return bank_size_; }
+
+ private:
+  static constexpr uint32_t Magic = 0x4B'56'53'31;
+  static constexpr std::size_t Bank_Header = 12;
+  static constexpr std::size_t Record_Header = 4;
+  static constexpr std::size_t Record_Max = Record_Header + Max_Value + 4;
+  static constexpr key_type Erased_Key = 0xFF'FF;
+  static constexpr std::size_t Table_Size = std::bit_ceil(Max_Keys * 2);
+
+  static_assert(Max_Value < 0xFF'FF, "Max_Value is too big");
+
+  // Index slot, size 0 marks a removed key
+  struct Entry {
+    key_type key = Erased_Key;
+    uint16_t size = 0;
+    uint32_t pos = 0;
+  };
+
+  ifc::IFlashMemory& flash_;
+  std::size_t const offset_;
+  std::size_t const bank_size_;
+  HashFAQ6 hash_;
+
+  std::array<Entry, Table_Size> slots_;
+  std::size_t keys_ = 0;
+  std::size_t bank_ = 0;
+  std::size_t pos_ = 0;
+  uint32_t seq_ = 0;
+
+  std::size_t bankAddress(std::size_t bank) {
+    return offset_ + bank * bank_size_;
+  }
+
+  std::size_t home(key_type key) {
+    return (key * 40'503u) & (Table_Size - 1);
+  }
+
+  std::optional<std::size_t> find(key_type key) {
+    for (auto i = home(key);; i = (i + 1) & (Table_Size - 1)) {
+      if (slots_[i].key == key) return i;
+      if (slots_[i].key == Erased_Key) return std::nullopt;
+    }
+  }
+
+  bool insert(Entry const& entry) {
+    if (auto slot = find(entry.key)) {
+      slots_[slot.value()] = entry;
+      return true;
+    }
+    if (keys_ == Max_Keys) return false;
+
+    auto i = home(entry.key);
+    while (slots_[i].key != Erased_Key) i = (i + 1) & (Table_Size - 1);
+    slots_[i] = entry;
+    ++keys_;
+    return true;
+  }
+
+  std::optional<uint32_t> readBankHeader(std::size_t bank) {
+    std::array<uint8_t, Bank_Header> raw;
+    if (!flash_.read(bankAddress(bank), raw)) return std::nullopt;
+    auto [magic, seq] = m::deserialize<uint32_t, uint32_t>(raw);
+
+    HashFAQ6::Hash hash;
+    std::copy_n(raw.begin() + 8, hash.size(), hash.begin());
+    if (magic != Magic || !hash_.check(std::span(raw).first(8), hash)) {
+      return std::nullopt;
+    }
+    return seq;
+  }
+
+  bool writeBankHeader(std::size_t bank, uint32_t seq) {
+    std::array<uint8_t, Bank_Header> raw;
+    m::serialize(raw, Magic, seq);
+    auto hash = hash_.calc(std::span(raw).first(8));
+    std::ranges::copy(hash, raw.begin() + 8);
+    return flash_.write(bankAddress(bank), raw);
+  }
+
+  // Walks the records of the active bank, a torn record or dirty bytes
+  // after the last record close the bank, records of keys that do not fit
+  // into the index are skipped
+  bool scan() {
+    slots_.fill(Entry{});
+    keys_ = 0;
+
+    std::array<uint8_t, Record_Max> record;
+    for (pos_ = Bank_Header; pos_ + Record_Header <= bank_size_;) {
+      auto address = bankAddress(bank_) + pos_;
+      auto header = std::span(record).first(Record_Header);
+      if (!flash_.read(address, header)) return false;
+      auto [key, size] = m::deserialize<key_type, uint16_t>(header);
+      if (key == Erased_Key && size == 0xFF'FF) return closeIfDirty();
+
+      auto record_size = Record_Header + size + 4;
+      if (size > Max_Value || pos_ + record_size > bank_size_) break;
+
+      auto span = std::span(record).first(record_size);
+      if (!flash_.read(address, span)) return false;
+      HashFAQ6::Hash hash;
+      std::copy_n(span.end() - hash.size(), hash.size(), hash.begin());
+      if (key != Erased_Key &&
+          hash_.check(span.first(Record_Header + size), hash)) {
+        insert(Entry{key, size, uint32_t(pos_)});
+      }
+      pos_ += record_size;
+    }
+
+    pos_ = bank_size_;
+    return true;
+  }
+
+  // Free space left dirty by a torn program must not take new records
+  bool closeIfDirty() {
+    std::array<uint8_t, 32> chunk;
+    for (auto pos = pos_; pos < bank_size_; pos += chunk.size()) {
+      auto span = std::span(chunk).first(
+          std::min<std::size_t>(chunk.size(), bank_size_ - pos));
+      if (!flash_.read(bankAddress(bank_) + pos, span)) return false;
+      if (!std::ranges::all_of(span, [](auto v) { return v == 0xFF; })) {
+        pos_ = bank_size_;
+        return true;
+      }
+    }
+    return true;
+  }
+
+  // Record is read back, a record that failed or does not match closes
+  // the bank, so the next append compacts instead of writing after it
+  bool append(key_type key, std::span<uint8_t const> data) {
+    auto record_size = Record_Header + data.size() + 4;
+    std::array<uint8_t, Record_Max> record;
+    m::serialize(record, key, uint16_t(data.size()));
+    std::ranges::copy(data, record.begin() + Record_Header);
+    auto span = std::span(record).first(record_size);
+    auto hash = hash_.calc(span.first(Record_Header + data.size()));
+    std::ranges::copy(hash, span.end() - hash.size());
+
+    // New key is refused before anything is programmed, only compaction
+    // drops removed keys from the index
+    auto full = [&] { return !find(key) && keys_ == Max_Keys; };
+    if (full() && std::ranges::none_of(slots_, [](auto& entry) {
+          return entry.key != Erased_Key && entry.size == 0;
+        })) {
+      return false;
+    }
+
+    if (pos_ + record_size > bank_size_ || full()) {
+      if (!compact()) return false;
+      if (pos_ + record_size > bank_size_ || full()) return false;
+    }
+
+    auto pos = pos_;
+    pos_ = bank_size_;
+    if (!flash_.write(bankAddress(bank_) + pos, span)) return false;
+
+    std::array<uint8_t, Record_Max> check;
+    auto back = std::span(check).first(record_size);
+    if (!flash_.read(bankAddress(bank_) + pos, back) ||
+        !std::ranges::equal(back, span)) {
+      return false;
+    }
+
+    pos_ = pos + record_size;
+    return insert(Entry{key, uint16_t(data.size()), uint32_t(pos)});
+  }
+};
+}  // namespace m
+
+#endif  // FLASHKVSTORE_H
@@ -0,0 +1,289 @@
+/**
+ * This file is part of m library.
+ *
+ * m library is free software: you can redistribute it and/or modify
+ * it under the terms of the MIT License. See the LICENSE file in the
+ * project root for more information.
+ *
+ * Copyright (c) 2025 Max Melekesov <max.melekesov@gmail.com>
+ */
+
+#ifndef BINARY_LOG_H
+#define BINARY_LOG_H
+
+#include <ILog.hpp>
+#include <TSerDes.hpp>
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <string_view>
+#include <utility>
+
+namespace m {
+
+// ##################################################
+// Usage Example:
+// m::IIO_AsyncLog<1'024, 63, m::LogProducers::Single,
+//                 m::LogOverflow::DropNewest, m::LogFraming::Binary>
+//     uart_log(uart);
+// using Formats = m::LogFormats<"boot", "temp=%f adc=%u">;
+// m::BinaryLog<Formats, 63> blog(uart_log);
+// blog.add<"temp=%f adc=%u">(25.5f, adc_value);
+//
+// Record on the wire: [len][id lo][id hi][args...], len counts bytes after
+// itself. Args are packed by the format specifiers, not by the C++ types:
+// %d %i - int32_t, %u %x %X %o - uint32_t, %lld - int64_t, %llu %llx -
+// uint64_t, %f %e %g - float, %c - char. h, l, z and t keep 32 bits on the
+// wire, ll and j take 64. %s, %p, %n, %a and * width are rejected at
+// compile time. Host side turns records back into text with
+// BinaryLogDecoder built from the same LogFormats table. The sink must
+// pass records whole, IIO_AsyncLog needs LogFraming::Binary.
+// Sink_Line_Length - longest add() the sink takes without cutting it,
+// Line_Length of IIO_AsyncLog, every record must fit into it
+// ##################################################
+
+template <std::size_t N>
+struct LogFormat {
+  consteval LogFormat(const char (&str)[N]) { std::copy_n(str, N, value); }
+  constexpr std::string_view view() const { return {value, N - 1}; }
+
+  char value[N];
+};
+
+enum class LogArg : uint8_t { I32, U32, I64, U64, F32, Char, Invalid };
+
+// Length modifier of a specifier, the decoder casts to the type it expects
+enum class LogLength : uint8_t {
+  None,
+  Char,
+  Short,
+  Long,
+  LongLong,
+  Max,
+  Size,
+  Ptrdiff,
+  LongDouble
+};
+
+template <LogArg Arg>
+struct LogArgType;
+template <>
+struct LogArgType<LogArg::I32> {
+  using type = int32_t;
+};
+template <>
+struct LogArgType<LogArg::U32> {
+  using type = uint32_t;
+};
+template <>
+struct LogArgType<LogArg::I64> {
+  using type = int64_t;
+};
+template <>
+struct LogArgType<LogArg::U64> {
+  using type = uint64_t;
+};
+template <>
+struct LogArgType<LogArg::F32> {
+  using type = float;
+};
+template <>
+struct LogArgType<LogArg::Char> {
+  using type = char;
+};
+
+constexpr std::size_t logArgSize(LogArg arg) {
+  switch (arg) {
+    case LogArg::I64:
+    case LogArg::U64:
+      return 8;
+    case LogArg::Char:
+      return 1;
+    case LogArg::Invalid:
+      return 0;
+    default:
+      return 4;
+  }
+}
+
+struct LogSpec {
+  std::size_t begin;
+  std::size_t end;
+  LogArg arg;
+  LogLength length;
+};
+
+constexpr LogArg logSpecArg(char conversion, LogLength length) {
+  auto wide = length == LogLength::LongLong || length == LogLength::Max;
+  switch (conversion) {
+    case 'd':
+    case 'i':
+      if (length == LogLength::LongDouble) return LogArg::Invalid;
+      return wide ? LogArg::I64 : LogArg::I32;
+    case 'u':
+    case 'x':
+    case 'X':
+    case 'o':
+      if (length == LogLength::LongDouble) return LogArg::Invalid;
+      return wide ? LogArg::U64 : LogArg::U32;
+    case 'f':
+    case 'F':
+    case 'e':
+    case 'E':
+    case 'g':
+    case 'G':
+      if (length != LogLength::None && length != LogLength::Long &&
+          length != LogLength::LongDouble) {
+        return LogArg::Invalid;
+      }
+      return LogArg::F32;
+    case 'c':
+      return length == LogLength::None ? LogArg::Char : LogArg::Invalid;
+    default:
+      return LogArg::Invalid;
+  }
+}
+
+// Next conversion specifier at or after pos, "%%" is skipped.
+// Scanning stops at the first character after flags, width, precision
+// and length, unsupported conversions come back as LogArg::Invalid.
+constexpr std::optional<LogSpec> nextLogSpec(std::string_view fmt,
+                                             std::size_t pos) {
+  for (; pos < fmt.size(); ++pos) {
+    if (fmt[pos] != '%') continue;
+    auto begin = pos++;
+    if (pos < fmt.size() && fmt[pos] == '%') continue;
+
+    constexpr std::string_view flags_width = "-+ #0123456789.";
+    while (pos < fmt.size() && std::ranges::count(flags_width, fmt[pos])) {
+      ++pos;
+    }
+
+    auto length = LogLength::None;
+    auto next = [&](std::size_t i) {
+      return pos + i < fmt.size() ? fmt[pos + i] : '\0';
+    };
+    switch (next(0)) {
+      case 'h':
+        length = next(1) == 'h' ? LogLength::Char : LogLength::Short;
+        break;
+      case 'l':
+        length = next(1) == 'l' ? LogLength::LongLong : LogLength::Long;
+        break;
+      case 'j':
+        length = LogLength::Max;
+        break;
+      case 'z':
+        length = LogLength::Size;
+        break;
+      case 't':
+        length = LogLength::Ptrdiff;
+        break;
+      case 'L':
+        length = LogLength::LongDouble;
+        break;
+      default:
+        break;
+    }
+    if (length == LogLength::Char || length == LogLength::LongLong) {
+      pos += 2;
+    } else if (length != LogLength::None) {
+      ++pos;
+    }
+
+    auto conversion = next(0);
+    auto end = pos < fmt.size() ? pos + 1 : pos;
+    return LogSpec{begin, end, logSpecArg(conversion, length), length};
+  }
+
+  return std::nullopt;
+}
+
+constexpr std::size_t logSpecCount(std::string_view fmt) {
+  std::size_t count = 0;
+  for (auto spec = nextLogSpec(fmt, 0); spec;
+       spec = nextLogSpec(fmt, spec->end)) {
+    ++count;
+  }
+  return count;
+}
+
+constexpr bool logFormatValid(std::string_view fmt) {
+  for (auto spec = nextLogSpec(fmt, 0); spec;
+       spec = nextLogSpec(fmt, spec->end)) {
+    if (spec->arg == LogArg::Invalid) return false;
+  }
+  return true;
+}
+
+template <LogFormat... Formats>
+struct LogFormats {
+  static constexpr std::array<std::string_view, sizeof...(Formats)> formats{
+      Formats.view()...};
+
+  static_assert(formats.size() <= 0xFF'FF, "Too many log formats");
+  static_assert((logFormatValid(Formats.view()) && ...),
+                "Unsupported conversion specifier in log format");
+
+  // Index of format in table, formats.size() if absent
+  static constexpr std::size_t id(std::string_view format) {
+    return std::ranges::find(formats, format) - formats.begin();
+  }
+};
+
+template <typename Formats, std::size_t Sink_Line_Length = 63>
+class BinaryLog {
+ public:
+  BinaryLog(ifc::ILog& log) : log_(log) {}
+
+  template <LogFormat Format, typename... Args>
+  void add(Args... args) {
+    constexpr auto id = Formats::id(Format.view());
+    static_assert(id < Formats::formats.size(),
+                  "Format is not in LogFormats table");
+
+    constexpr auto specs = parse<Format>();
+    static_assert(specs.size() == sizeof...(Args),
+                  "Arguments number does not match format");
+
+    emit<static_cast<uint16_t>(id), specs>(
+        std::index_sequence_for<Args...>{}, args...);
+  }
+
+ private:
+  ifc::ILog& log_;
+
+  template <LogFormat Format>
+  static consteval auto parse() {
+    std::array<LogArg, logSpecCount(Format.view())> specs{};
+    std::size_t pos = 0;
+    for (auto& spec : specs) {
+      auto next = nextLogSpec(Format.view(), pos);
+      spec = next->arg;
+      pos = next->end;
+    }
+    return specs;
+  }
+
+  template <uint16_t Id, auto Specs, std::size_t... Is, typename... Args>
+  void emit(std::index_sequence<Is...>, Args... args) {
+    constexpr std::size_t args_size = (logArgSize(Specs[Is]) + ... + 0);
+    static_assert(args_size + 2 <= 0xFF, "Record is too long");
+    static_assert(3 + args_size <= Sink_Line_Length,
+                  "Record is longer than a sink line");
+
+    std::array<uint8_t, 3 + args_size> record;
+    record[0] = static_cast<uint8_t>(record.size() - 1);
+    m::serialize(std::span(record).subspan(1), Id,
+                 static_cast<typename LogArgType<Specs[Is]>::type>(args)...);
+
+    log_.add(std::string_view(reinterpret_cast<const char*>(record.data()),
+                              record.size()));
+  }
+};
+
+}  // namespace m
+
+#endif  // BINARY_LOG_H
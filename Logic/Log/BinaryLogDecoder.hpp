@@ -0,0 +1,164 @@
+/**
+ * This file is part of m library.
+ *
+ * m library is free software: you can redistribute it and/or modify
+ * it under the terms of the MIT License. See the LICENSE file in the
+ * project root for more information.
+ *
+ * Copyright (c) 2025 Max Melekesov <max.melekesov@gmail.com>
+ */
+
+#ifndef BINARY_LOG_DECODER_H
+#define BINARY_LOG_DECODER_H
+
+#include <BinaryLog.hpp>
+#include <TSerDes.hpp>
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <optional>
+#include <span>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+
+namespace m {
+
+// Host side part of BinaryLog, uses snprintf and is not meant for the MCU.
+// Formats must be the same LogFormats table the firmware was built with.
+template <typename Formats>
+class BinaryLogDecoder {
+ public:
+  // Decodes the record at the start of data into text.
+  // Returns {consumed bytes, text length}, nullopt if record is incomplete.
+  std::optional<std::tuple<std::size_t, std::size_t>> decode(
+      std::span<uint8_t const> data, std::span<char> text) {
+    if (data.empty() || data.size() < data[0] + 1u) return std::nullopt;
+
+    std::size_t consumed = data[0] + 1u;
+    auto record = data.subspan(1, data[0]);
+    if (text.empty()) return std::tuple{consumed, 0};
+
+    if (record.size() < 2) return std::tuple{consumed, print(text, "<bad>")};
+    auto [id] = m::deserialize<uint16_t>(record);
+    record = record.subspan(2);
+
+    if (id >= Formats::formats.size()) {
+      return std::tuple{consumed, print(text, "<unknown id %u>", id)};
+    }
+
+    auto fmt = Formats::formats[id];
+    std::size_t len = 0;
+    std::size_t pos = 0;
+    for (auto spec = nextLogSpec(fmt, 0);; spec = nextLogSpec(fmt, pos)) {
+      auto literal_end = spec ? spec->begin : fmt.size();
+      len += literal(text.subspan(len), fmt.substr(pos, literal_end - pos));
+      if (!spec) break;
+
+      if (record.size() < logArgSize(spec->arg)) {
+        len += print(text.subspan(len), "<truncated>");
+        break;
+      }
+      len += arg(text.subspan(len),
+                 fmt.substr(spec->begin, spec->end - spec->begin),
+                 spec.value(), record);
+      record = record.subspan(logArgSize(spec->arg));
+      pos = spec->end;
+    }
+
+    return std::tuple{consumed, len};
+  }
+
+ private:
+  // Copies format text with "%%" collapsed, output is always NUL terminated
+  std::size_t literal(std::span<char> text, std::string_view fmt) {
+    std::size_t len = 0;
+    for (std::size_t i = 0; i < fmt.size() && len + 1 < text.size(); ++i) {
+      if (fmt[i] == '%' && i + 1 < fmt.size() && fmt[i + 1] == '%') ++i;
+      text[len++] = fmt[i];
+    }
+    if (!text.empty()) text[len] = '\0';
+    return len;
+  }
+
+  std::size_t arg(std::span<char> text, std::string_view spec_text,
+                  LogSpec const& spec, std::span<uint8_t const> data) {
+    std::array<char, 16> fmt{};
+    if (spec_text.size() >= fmt.size()) return print(text, "<spec>");
+    spec_text.copy(fmt.data(), spec_text.size());
+
+    switch (spec.arg) {
+      case LogArg::I32:
+        return integer(text, fmt.data(), spec.length, value<int32_t>(data));
+      case LogArg::U32:
+        return integer(text, fmt.data(), spec.length, value<uint32_t>(data));
+      case LogArg::I64:
+        return integer(text, fmt.data(), spec.length, value<int64_t>(data));
+      case LogArg::U64:
+        return integer(text, fmt.data(), spec.length, value<uint64_t>(data));
+      case LogArg::F32:
+        if (spec.length == LogLength::LongDouble) {
+          return print(text, fmt.data(),
+                       static_cast<long double>(value<float>(data)));
+        }
+        return print(text, fmt.data(),
+                     static_cast<double>(value<float>(data)));
+      case LogArg::Char:
+        return print(text, fmt.data(), value<char>(data));
+      case LogArg::Invalid:
+        return print(text, "<spec>");
+    }
+
+    return 0;
+  }
+
+  // Value is passed as the type the length modifier of fmt expects
+  template <typename T>
+  std::size_t integer(std::span<char> text, const char* fmt,
+                      LogLength length, T v) {
+    using ssize = std::make_signed_t<std::size_t>;
+    using uptrdiff = std::make_unsigned_t<std::ptrdiff_t>;
+    switch (length) {
+      case LogLength::Long:
+        return printAs<long, unsigned long>(text, fmt, v);
+      case LogLength::LongLong:
+        return printAs<long long, unsigned long long>(text, fmt, v);
+      case LogLength::Max:
+        return printAs<intmax_t, uintmax_t>(text, fmt, v);
+      case LogLength::Size:
+        return printAs<ssize, std::size_t>(text, fmt, v);
+      case LogLength::Ptrdiff:
+        return printAs<std::ptrdiff_t, uptrdiff>(text, fmt, v);
+      default:
+        return printAs<int, unsigned>(text, fmt, v);
+    }
+  }
+
+  template <typename Signed, typename Unsigned, typename T>
+  std::size_t printAs(std::span<char> text, const char* fmt, T v) {
+    if constexpr (std::is_signed_v<T>) {
+      return print(text, fmt, static_cast<Signed>(v));
+    } else {
+      return print(text, fmt, static_cast<Unsigned>(v));
+    }
+  }
+
+  template <typename T>
+  T value(std::span<uint8_t const> data) {
+    return std::get<0>(m::deserialize<T>(data));
+  }
+
+  template <typename... Args>
+  std::size_t print(std::span<char> text, const char* fmt, Args... args) {
+    if (text.empty()) return 0;
+    auto len = std::snprintf(text.data(), text.size(), fmt, args...);
+    if (len < 0) return 0;
+    return std::min<std::size_t>(len, text.size() - 1);
+  }
+};
+
+}  // namespace m
+
+#endif  // BINARY_LOG_DECODER_H
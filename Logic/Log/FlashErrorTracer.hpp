@@ -0,0 +1,311 @@
+/**
+ * This file is part of m library.
+ *
+ * m library is free software: you can redistribute it and/or modify
+ * it under the terms of the MIT License. See the LICENSE file in the
+ * project root for more information.
+ *
+ * Copyright (c) 2025 Max Melekesov <max.melekesov@gmail.com>
+ */
+
+#ifndef FLASHERRORTRACER_H
+#define FLASHERRORTRACER_H
+
+#include <HashFAQ6.hpp>
+#include <IErrorTracer.hpp>
+#include <IFlashMemory.hpp>
+#include <TSerDes.hpp>
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <optional>
+#include <span>
+#include <type_traits>
+
+namespace m {
+
+// Error trace that survives resets, journaled into a region of flash.
+// add() only stores the error in RAM. handle() programs whole pages of
+// {magic, seq, count, entries..., HashFAQ6} and erases the next sector in
+// advance with IFlashMemory::startErase(), one flash operation per call,
+// the erase is polled by the following calls. Errors are written once a
+// page is full or after flush(). A page torn by power loss fails the hash
+// and is skipped on boot. init() reads the first page header of every
+// sector and then only the pages needed to refill the last Max_Elements
+// errors.
+template <typename T, std::size_t Max_Elements, std::size_t Page_Size = 256,
+          std::size_t Sector_Size = 4'096>
+class FlashErrorTracer : public m::ifc::IErrorTracer<T> {
+ public:
+  using type = T;
+
+  static_assert(std::is_trivially_copyable_v<type>,
+                "Error type must be trivially copyable");
+
+  FlashErrorTracer(ifc::IFlashMemory& flash, std::size_t offset,
+                   std::size_t size)
+      : flash_(flash), offset_(offset), sectors_(size / Sector_Size) {}
+
+  // Restores the trace from flash and finds the write position
+  bool init() {
+    if (sectors_ < 2) return false;
+
+    // Only pages whose hash matches are trusted, a header torn mid-program
+    // may carry a valid magic with a garbage seq
+    std::array<uint8_t, Page_Size> data;
+    has_current_ = false;
+    for (std::size_t i = 0; i < sectors_; ++i) {
+      auto header = readPage(i * Pages_Per_Sector, data);
+      if (header && (!has_current_ || header->seq > seq_)) {
+        seq_ = header->seq;
+        sector_ = i;
+        has_current_ = true;
+      }
+    }
+
+    size_ = 0;
+    pending_ = 0;
+    if (!has_current_) {
+      sector_ = 0;
+      seq_ = 0;
+      return true;
+    }
+
+    // Pages of a sector are written in order, torn page is skipped
+    for (page_ = 0; page_ < Pages_Per_Sector; ++page_) {
+      std::array<uint8_t, Header_Size> raw;
+      if (!flash_.read(pageAddress(sector_ * Pages_Per_Sector + page_), raw)) {
+        return false;
+      }
+      if (std::ranges::all_of(raw, [](auto v) { return v == 0xFF; })) break;
+      if (auto header = readPage(sector_ * Pages_Per_Sector + page_, data)) {
+        seq_ = std::max(seq_, header->seq);
+      }
+    }
+    ++seq_;
+
+    if (!restore()) return false;
+
+    return sectorErased(nextSector(sector_), next_erased_);
+  }
+
+  bool add(type value) override {
+    if (size_ == Max_Elements) {
+      std::shift_left(trace_.begin(), trace_.end(), 1);
+      --size_;
+    }
+    trace_[size_++] = value;
+    pending_ = std::min(pending_ + 1, size_);
+    return true;
+  }
+
+  // Forgets the trace in RAM, flash keeps the history
+  void clear() override {
+    size_ = 0;
+    pending_ = 0;
+  }
+
+  std::span<type> getTrace() override {
+    return std::span<type>{trace_.data(), size_};
+  }
+
+  // Next handle() calls write pending errors even if the page is not full
+  void flush() { flush_ = true; }
+
+  bool flushed() { return pending_ == 0; }
+
+  bool handle() {
+    if (erasing_) {
+      auto done = flash_.eraseDone();
+      if (!done) {
+        erasing_ = false;
+        return false;
+      }
+      if (!done.value()) return true;
+      erasing_ = false;
+
+      if (has_current_) {
+        next_erased_ = true;
+      } else {
+        has_current_ = true;
+        next_erased_ = false;
+        page_ = 0;
+      }
+      return true;
+    }
+
+    if (!has_current_ || !next_erased_) {
+      auto sector = has_current_ ? nextSector(sector_) : sector_;
+      if (!flash_.startErase(sectorAddress(sector), Sector_Size)) {
+        return false;
+      }
+      erasing_ = true;
+      return true;
+    }
+
+    if (pending_ == 0) {
+      flush_ = false;
+      return true;
+    }
+    if (pending_ < Per_Page && !flush_) return true;
+
+    if (page_ == Pages_Per_Sector) {
+      sector_ = nextSector(sector_);
+      page_ = 0;
+      next_erased_ = false;
+      return true;
+    }
+
+    uint16_t count = std::min(pending_, Per_Page);
+    std::array<uint8_t, Page_Size> page;
+    page.fill(0xFF);
+    m::serialize(page, Magic, seq_, count);
+    std::memcpy(page.data() + Header_Size, trace_.data() + size_ - pending_,
+                count * sizeof(type));
+    auto data_size = Header_Size + count * sizeof(type);
+    auto hash = hash_.calc(std::span(page).first(data_size));
+    std::ranges::copy(hash, page.begin() + data_size);
+
+    if (!flash_.write(pageAddress(sector_ * Pages_Per_Sector + page_),
+                      std::span(page).first(data_size + hash.size()))) {
+      return false;
+    }
+
+    ++page_;
+    ++seq_;
+    pending_ -= count;
+    return true;
+  }
+
+ private:
+  static constexpr uint32_t Magic = 0x45'52'52'31;
+  static constexpr std::size_t Header_Size = 10;
+  static constexpr std::size_t Pages_Per_Sector = Sector_Size / Page_Size;
+  static constexpr std::size_t Per_Page =
+      (Page_Size - Header_Size - 4) / sizeof(type);
+
+  static_assert(Per_Page > 0, "Page_Size is too small for error type");
+  static_assert(Sector_Size % Page_Size == 0, "Wrong Page_Size");
+
+  struct Header {
+    uint32_t seq;
+    uint16_t count;
+  };
+
+  ifc::IFlashMemory& flash_;
+  std::size_t const offset_;
+  std::size_t const sectors_;
+  HashFAQ6 hash_;
+
+  std::array<type, Max_Elements> trace_;
+  std::size_t size_ = 0;
+  std::size_t pending_ = 0;
+  bool flush_ = false;
+
+  std::size_t sector_ = 0;
+  std::size_t page_ = 0;
+  uint32_t seq_ = 0;
+  bool has_current_ = false;
+  bool next_erased_ = false;
+  bool erasing_ = false;
+
+  std::size_t sectorAddress(std::size_t sector) {
+    return offset_ + sector * Sector_Size;
+  }
+
+  std::size_t pageAddress(std::size_t page) {
+    return offset_ + page * Page_Size;
+  }
+
+  std::size_t nextSector(std::size_t sector) {
+    return (sector + 1) % sectors_;
+  }
+
+  std::optional<Header> readHeader(std::size_t page) {
+    std::array<uint8_t, Header_Size> raw;
+    if (!flash_.read(pageAddress(page), raw)) return std::nullopt;
+    auto [magic, seq, count] =
+        m::deserialize<uint32_t, uint32_t, uint16_t>(raw);
+    if (magic != Magic || count == 0 || count > Per_Page) return std::nullopt;
+    return Header{seq, count};
+  }
+
+  // Header of a page whose hash matches, entries are left in data
+  std::optional<Header> readPage(std::size_t page,
+                                 std::array<uint8_t, Page_Size>& data) {
+    auto header = readHeader(page);
+    if (!header) return std::nullopt;
+
+    auto data_size = Header_Size + header->count * sizeof(type);
+    if (!flash_.read(pageAddress(page),
+                     std::span(data).first(data_size + 4))) {
+      return std::nullopt;
+    }
+
+    HashFAQ6::Hash stored;
+    std::copy_n(data.begin() + data_size, stored.size(), stored.begin());
+    if (!hash_.check(std::span(data).first(data_size), stored)) {
+      return std::nullopt;
+    }
+
+    return header;
+  }
+
+  // Walks back from the newest page until Max_Elements errors are found,
+  // then reads those pages forward
+  bool restore() {
+    auto total = sectors_ * Pages_Per_Sector;
+    auto page = sector_ * Pages_Per_Sector + page_;
+    std::array<uint8_t, Page_Size> data;
+
+    std::size_t first = page;
+    std::size_t found = 0;
+    uint32_t seq = seq_;
+    for (std::size_t i = 0; i < total && found < Max_Elements; ++i) {
+      auto prev = (page + total - 1 - i) % total;
+      auto header = readPage(prev, data);
+      if (!header) {
+        // Page torn by power loss is skipped, its seq is not trusted
+        if (!readHeader(prev)) break;
+        first = prev;
+        continue;
+      }
+      if (header->seq >= seq) break;
+      seq = header->seq;
+      first = prev;
+      found += header->count;
+    }
+
+    for (auto p = first; p != page; p = (p + 1) % total) {
+      auto header = readPage(p, data);
+      if (!header) continue;
+      for (std::size_t i = 0; i < header->count; ++i) {
+        type value;
+        std::memcpy(&value, data.data() + Header_Size + i * sizeof(type),
+                    sizeof(type));
+        add(value);
+      }
+    }
+    pending_ = 0;
+
+    return true;
+  }
+
+  bool sectorErased(std::size_t sector, bool& erased) {
+    std::array<uint8_t, 32> chunk;
+    for (std::size_t addr = 0; addr < Sector_Size; addr += chunk.size()) {
+      if (!flash_.read(sectorAddress(sector) + addr, chunk)) return false;
+      if (!std::ranges::all_of(chunk, [](auto v) { return v == 0xFF; })) {
+        erased = false;
+        return true;
+      }
+    }
+    erased = true;
+    return true;
+  }
+};
+
+}  // namespace m
+
+#endif  // FLASHERRORTRACER_H
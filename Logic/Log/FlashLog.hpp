@@ -0,0 +1,270 @@
+/**
+ * This file is part of m library.
+ *
+ * m library is free software: you can redistribute it and/or modify
+ * it under the terms of the MIT License. See the LICENSE file in the
+ * project root for more information.
+ *
+ * Copyright (c) 2025 Max Melekesov <max.melekesov@gmail.com>
+ */
+
+#ifndef FLASH_LOG_H
+#define FLASH_LOG_H
+
+#include <IFlashMemory.hpp>
+#include <ILog.hpp>
+#include <TSerDes.hpp>
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <string_view>
+
+namespace m {
+
+// Persistent log ring in a region of flash memory.
+// Region is split into Sector_Size sectors, each starts with a header
+// {magic, sequence number} followed by records [len][text...], len 0xFF
+// marks the end of written data. On boot init() reads one header per sector
+// to find the newest one.
+// add() only copies the record to a RAM queue, handle() does at most one
+// flash operation per call. The sector after the current one is erased in
+// advance with IFlashMemory::startErase() and handle() polls it, records
+// stay in the queue meanwhile. Capacity is one sector less than the region.
+template <std::size_t Sector_Size = 4'096, std::size_t Queue_Size = 256,
+          std::size_t Write_Chunk = 256>
+class FlashLog : public ifc::ILog {
+ public:
+  struct Cursor {
+    std::size_t sector;
+    std::size_t offset;
+    uint32_t seq;
+  };
+
+  FlashLog(ifc::IFlashMemory& flash, std::size_t offset, std::size_t size)
+      : flash_(flash), offset_(offset), sectors_(size / Sector_Size) {}
+
+  // Finds the newest sector and the write position in it
+  bool init() {
+    if (sectors_ < 2) return false;
+
+    has_current_ = false;
+    for (std::size_t i = 0; i < sectors_; ++i) {
+      auto seq = readHeader(i);
+      if (seq && (!has_current_ || seq.value() > seq_)) {
+        seq_ = seq.value();
+        sector_ = i;
+        has_current_ = true;
+      }
+    }
+
+    if (!has_current_) {
+      sector_ = 0;
+      seq_ = 0;
+      return true;
+    }
+
+    write_offset_ = Header_Size;
+    while (write_offset_ < Sector_Size) {
+      auto len = readLen(sector_, write_offset_);
+      if (!len) return false;
+      if (len.value() == End) break;
+      write_offset_ += len.value() + 1;
+    }
+
+    // Whole sector, an erase cut by power loss may leave the header blank
+    next_erased_ = true;
+    std::array<uint8_t, 32> chunk;
+    for (std::size_t offset = 0; offset < Sector_Size && next_erased_;
+         offset += chunk.size()) {
+      auto span = std::span(chunk).first(
+          std::min(chunk.size(), Sector_Size - offset));
+      if (!flash_.read(address(nextSector(sector_), offset), span)) {
+        return false;
+      }
+      next_erased_ =
+          std::ranges::all_of(span, [](auto v) { return v == 0xFF; });
+    }
+
+    return true;
+  }
+
+  void add(std::string_view text) override {
+    auto data = text.substr(0, End - 1);
+    if (Queue_Size - queue_size_ < data.size() + 1) {
+      ++dropped_;
+      return;
+    }
+
+    queue_[queue_size_++] = data.size();
+    std::ranges::copy(data, queue_.begin() + queue_size_);
+    queue_size_ += data.size();
+  }
+
+  bool handle() {
+    if (erasing_) {
+      auto done = flash_.eraseDone();
+      if (!done) {
+        erasing_ = false;
+        return false;
+      }
+      if (!done.value()) return true;
+      erasing_ = false;
+
+      if (has_current_) {
+        next_erased_ = true;
+        return true;
+      }
+      if (!writeHeader(sector_, seq_)) return false;
+      has_current_ = true;
+      next_erased_ = false;
+      write_offset_ = Header_Size;
+      return true;
+    }
+
+    if (!has_current_ || !next_erased_) {
+      auto sector = has_current_ ? nextSector(sector_) : sector_;
+      if (!flash_.startErase(address(sector, 0), Sector_Size)) return false;
+      erasing_ = true;
+      return true;
+    }
+
+    if (queue_size_ == 0) return true;
+
+    if (write_offset_ + queue_[0] + 1 > Sector_Size) {
+      if (!writeHeader(nextSector(sector_), seq_ + 1)) return false;
+      sector_ = nextSector(sector_);
+      ++seq_;
+      next_erased_ = false;
+      write_offset_ = Header_Size;
+      return true;
+    }
+
+    // Whole records only, so a record never crosses a sector
+    auto space = std::min(Write_Chunk, Sector_Size - write_offset_);
+    std::size_t size = 0;
+    while (size < queue_size_ && size + queue_[size] + 1 <= space) {
+      size += queue_[size] + 1;
+    }
+
+    if (!flash_.write(address(sector_, write_offset_),
+                      std::span(queue_).first(size))) {
+      return false;
+    }
+
+    write_offset_ += size;
+    std::copy(queue_.begin() + size, queue_.begin() + queue_size_,
+              queue_.begin());
+    queue_size_ -= size;
+
+    return true;
+  }
+
+  // Cursor at the oldest record in flash
+  Cursor begin() {
+    for (std::size_t i = 1; i <= sectors_; ++i) {
+      auto sector = (sector_ + i) % sectors_;
+      if (auto seq = readHeader(sector); seq && seq.value() <= seq_) {
+        return Cursor{sector, Header_Size, seq.value()};
+      }
+    }
+    return Cursor{sector_, Header_Size, seq_};
+  }
+
+  // Copies record at cursor to data and advances cursor.
+  // Returns record size (may be larger than data), nullopt at the end.
+  std::optional<std::size_t> read(Cursor& cursor, std::span<uint8_t> data) {
+    if (!has_current_) return std::nullopt;
+
+    while (true) {
+      if (cursor.sector == sector_ && cursor.seq == seq_ &&
+          cursor.offset >= write_offset_) {
+        return std::nullopt;
+      }
+
+      std::optional<uint8_t> len = End;
+      if (cursor.offset < Sector_Size) {
+        len = readLen(cursor.sector, cursor.offset);
+        if (!len) return std::nullopt;
+      }
+
+      if (len.value() != End) {
+        auto size = std::min<std::size_t>(len.value(), data.size());
+        if (!flash_.read(address(cursor.sector, cursor.offset + 1),
+                         data.first(size))) {
+          return std::nullopt;
+        }
+        cursor.offset += len.value() + 1;
+        return len.value();
+      }
+
+      // Sector is done, next one must continue the sequence
+      auto next = nextSector(cursor.sector);
+      auto seq = readHeader(next);
+      if (!seq || seq.value() != cursor.seq + 1) return std::nullopt;
+      cursor = Cursor{next, Header_Size, seq.value()};
+    }
+  }
+
+  // Records lost because the RAM queue was full
+  uint32_t getDropped() { return dropped_; }
+
+  // Queue is empty, everything added so far is in flash
+  bool flushed() { return queue_size_ == 0; }
+
+ private:
+  static constexpr uint32_t Magic = 0x4C'4F'47'31;
+  static constexpr std::size_t Header_Size = 8;
+  static constexpr uint8_t End = 0xFF;
+
+  static_assert(Sector_Size > Header_Size + End, "Sector_Size is too small");
+  static_assert(Queue_Size >= End, "Queue_Size is too small");
+
+  ifc::IFlashMemory& flash_;
+  std::size_t const offset_;
+  std::size_t const sectors_;
+
+  std::size_t sector_ = 0;
+  uint32_t seq_ = 0;
+  std::size_t write_offset_ = Header_Size;
+  bool has_current_ = false;
+  bool next_erased_ = false;
+  bool erasing_ = false;
+
+  std::array<uint8_t, Queue_Size> queue_;
+  std::size_t queue_size_ = 0;
+  uint32_t dropped_ = 0;
+
+  std::size_t address(std::size_t sector, std::size_t offset) {
+    return offset_ + sector * Sector_Size + offset;
+  }
+
+  std::size_t nextSector(std::size_t sector) {
+    return (sector + 1) % sectors_;
+  }
+
+  std::optional<uint32_t> readHeader(std::size_t sector) {
+    std::array<uint8_t, Header_Size> header;
+    if (!flash_.read(address(sector, 0), header)) return std::nullopt;
+    auto [magic, seq] = m::deserialize<uint32_t, uint32_t>(header);
+    if (magic != Magic) return std::nullopt;
+    return seq;
+  }
+
+  bool writeHeader(std::size_t sector, uint32_t seq) {
+    std::array<uint8_t, Header_Size> header;
+    m::serialize(header, Magic, seq);
+    return flash_.write(address(sector, 0), header);
+  }
+
+  std::optional<uint8_t> readLen(std::size_t sector, std::size_t offset) {
+    std::array<uint8_t, 1> len;
+    if (!flash_.read(address(sector, offset), len)) return std::nullopt;
+    return len[0];
+  }
+};
+
+}  // namespace m
+
+#endif  // FLASH_LOG_H
@@ -15,49 +15,264 @@
 #include <ILog.hpp>
 #include <algorithm>
 #include <array>
-#include <ranges>
+#include <atomic>
+#include <bit>
+#include <charconv>
+#include <cstdint>
+#include <optional>
 #include <string_view>
 
 namespace m {
 
-template <std::size_t Line_Length = 63, std::size_t Lines = 100>
+// Single - one producer context (main loop or one ISR), wait-free add()
+// Multi - any number of nested producers (ISRs of different priority and
+// main loop), space is reserved with compare-exchange, needs CAS support
+// (Cortex-M3 and newer)
+enum class LogProducers : uint8_t { Single, Multi };
+
+// What add() does when the ring is full:
+// DropNewest - new line is dropped
+// OverwriteOldest - oldest unsent lines are discarded, lines are expected to
+// end with '\n'; Single producer only, space is not reclaimed while a
+// transfer is in progress
+// Block - add() runs handle() until space is free or block limit is reached,
+// Single producer only and add() must be called from the handle() context
+// Text framing reports dropped lines by a "[N messages dropped]" line.
+enum class LogOverflow : uint8_t { DropNewest, OverwriteOldest, Block };
+
+// Text - lines end with '\n', dropped lines are reported in the stream
+// Binary - every add() is an opaque record (BinaryLog, TimestampLog), so
+// nothing is injected into the stream and records are never cut, drops
+// are seen only in getDropped(); OverwriteOldest is not available
+enum class LogFraming : uint8_t { Text, Binary };
+
+// Lines are kept back to back in a byte ring, handle() sends the largest
+// contiguous run of pending bytes in one transfer.
+// Buffer_Size - ring size in bytes, power of 2. It comes first so that
+// <Line_Length, Lines> of the former line array does not compile.
+// Line_Length - max length of one line, longer lines are truncated,
+// longer Binary records are dropped
+// handle() must be called from a single context
+template <std::size_t Buffer_Size = 1'024, std::size_t Line_Length = 63,
+          LogProducers Producers = LogProducers::Single,
+          LogOverflow Overflow = LogOverflow::DropNewest,
+          LogFraming Framing = LogFraming::Text>
 class IIO_AsyncLog : public m::ifc::ILog {
+  // Ring positions are 24 bit wrapping counters
+  static constexpr uint32_t Pos_Mask = 0xFF'FF'FF;
+
+  static_assert(Buffer_Size >= Line_Length, "Buffer_Size < Line_Length");
+  static_assert(std::has_single_bit(Buffer_Size),
+                "Buffer_Size must be power of 2");
+  static_assert(Buffer_Size <= (Pos_Mask + 1) / 2, "Buffer_Size too big");
+  static_assert(Overflow == LogOverflow::DropNewest ||
+                    Producers == LogProducers::Single,
+                "Overflow policy requires single producer");
+  static_assert(Overflow != LogOverflow::OverwriteOldest ||
+                    Framing == LogFraming::Text,
+                "OverwriteOldest needs Text framing");
+
  public:
   IIO_AsyncLog(m::ifc::IIO_Async& io) : io_(io) {}
 
   void add(std::string_view text) override {
-    if (count_ < Lines) {
-      auto truncated_text = text | std::views::take(Line_Length);
-      std::ranges::copy(truncated_text, buffer_[write_index_].begin());
-      buffer_[write_index_][truncated_text.size()] = '\0';
-      write_index_ = (write_index_ + 1) % Lines;
-      ++count_;
+    if constexpr (Framing == LogFraming::Text) pushMarker();
+
+    // A cut record would throw the decoder out of sync
+    auto whole = Framing == LogFraming::Text || text.size() <= Line_Length;
+    if (!whole || !push(text.substr(0, Line_Length))) {
+      dropped_.fetch_add(1, std::memory_order_relaxed);
+      dropped_total_.fetch_add(1, std::memory_order_relaxed);
     }
   }
 
   void handle() {
-    if (count_ > 0 && io_.writeDone()) {
-      auto& line = buffer_[read_index_];
-      if (io_.writeAsync(std::span<const uint8_t>(
-              reinterpret_cast<const uint8_t*>(line.data()),
-              std::ranges::distance(line | std::views::take_while([](char c) {
-                                      return c != '\0';
-                                    })))) == true) {
-        read_index_ = (read_index_ + 1) % Lines;
-        --count_;
-      } else {
-        io_.abortWrite();
-      }
+    if (!io_.writeDone()) return;
+
+    // Everything sent or discarded before send_pos_ is free once DMA is done
+    auto send_pos = send_pos_.load(std::memory_order_acquire);
+    read_pos_.store(send_pos, std::memory_order_release);
+
+    auto count =
+        distance(commit_pos_.load(std::memory_order_acquire), send_pos);
+    if (count == 0) return;
+
+    auto index = send_pos % Buffer_Size;
+    auto size = std::min<std::size_t>(count, Buffer_Size - index);
+    uint32_t sent_pos = (send_pos + size) & Pos_Mask;
+    if (!send_pos_.compare_exchange_strong(send_pos, sent_pos,
+                                           std::memory_order_acq_rel)) {
+      return;  // Producer has discarded these lines
     }
+
+    if (io_.writeAsync(std::span<const uint8_t>(buffer_.data() + index,
+                                                size)) != true) {
+      send_pos_.compare_exchange_strong(sent_pos, send_pos,
+                                        std::memory_order_acq_rel);
+      io_.abortWrite();
+    }
+  }
+
+  // Lines dropped or overwritten since start
+  uint32_t getDropped() {
+    return dropped_total_.load(std::memory_order_relaxed);
   }
 
+  // Max bytes held in ring since start or resetHighWater()
+  uint32_t getHighWater() {
+    return high_water_.load(std::memory_order_relaxed);
+  }
+
+  void resetHighWater() { high_water_.store(0, std::memory_order_relaxed); }
+
+  // Block mode: max handle() calls a single add() may wait for
+  void setBlockLimit(uint32_t tries) { block_limit_ = tries; }
+
  private:
   m::ifc::IIO_Async& io_;
 
-  std::array<std::array<char, Line_Length + 1>, Lines> buffer_;
-  std::size_t write_index_ = 0;
-  std::size_t read_index_ = 0;
-  std::size_t count_ = 0;
+  std::array<uint8_t, Buffer_Size> buffer_;
+
+  // Bytes before read_pos_ are free, bytes before send_pos_ are sent or
+  // discarded, bytes before commit_pos_ are complete and may be sent
+  std::atomic<uint32_t> read_pos_{0};
+  std::atomic<uint32_t> send_pos_{0};
+  std::atomic<uint32_t> commit_pos_{0};
+
+  // Multi mode: reserved position << 8 | number of unfinished writers
+  std::atomic<uint32_t> reserve_state_{0};
+
+  // Not yet reported by a marker line
+  std::atomic<uint32_t> dropped_{0};
+  std::atomic<uint32_t> dropped_total_{0};
+  std::atomic<uint32_t> high_water_{0};
+
+  uint32_t block_limit_ = 10'000;
+
+  static uint32_t distance(uint32_t to, uint32_t from) {
+    return (to - from) & Pos_Mask;
+  }
+
+  bool fits(uint32_t pos, uint32_t size) {
+    auto used = distance(pos, read_pos_.load(std::memory_order_acquire));
+    return Buffer_Size - used >= size;
+  }
+
+  // Reports lines dropped since the last marker
+  void pushMarker() {
+    auto dropped = dropped_.exchange(0, std::memory_order_relaxed);
+    if (dropped == 0) return;
+
+    std::array<char, 32> marker;
+    auto* end = marker.data();
+    *end++ = '[';
+    end = std::to_chars(end, marker.data() + 11, dropped).ptr;
+    std::string_view suffix = " messages dropped]\n";
+    end = std::ranges::copy(suffix, end).out;
+
+    if (!push(std::string_view(marker.data(), end - marker.data()))) {
+      dropped_.fetch_add(dropped, std::memory_order_relaxed);
+    }
+  }
+
+  bool push(std::string_view text) {
+    uint32_t size = text.size();
+
+    auto pos = reserve(size);
+    if constexpr (Overflow == LogOverflow::OverwriteOldest) {
+      if (!pos && discard(size)) pos = reserve(size);
+    } else if constexpr (Overflow == LogOverflow::Block) {
+      for (uint32_t i = 0; !pos && i < block_limit_; ++i) {
+        handle();
+        pos = reserve(size);
+      }
+    }
+    if (!pos) return false;
+
+    auto index = pos.value() % Buffer_Size;
+    auto tail = std::min<std::size_t>(size, Buffer_Size - index);
+    std::ranges::copy(text.substr(0, tail), buffer_.begin() + index);
+    std::ranges::copy(text.substr(tail), buffer_.begin());
+
+    auto end = (pos.value() + size) & Pos_Mask;
+    auto used = distance(end, read_pos_.load(std::memory_order_relaxed));
+    auto high_water = high_water_.load(std::memory_order_relaxed);
+    while (used > high_water &&
+           !high_water_.compare_exchange_weak(high_water, used,
+                                              std::memory_order_relaxed)) {
+    }
+
+    commit(pos.value(), size);
+    return true;
+  }
+
+  std::optional<uint32_t> reserve(uint32_t size) {
+    if constexpr (Producers == LogProducers::Single) {
+      auto pos = commit_pos_.load(std::memory_order_relaxed);
+      if (!fits(pos, size)) return std::nullopt;
+      return pos;
+    } else {
+      auto state = reserve_state_.load(std::memory_order_relaxed);
+      uint32_t pos;
+      do {
+        pos = state >> 8;
+        if ((state & 0xFF) == 0xFF || !fits(pos, size)) return std::nullopt;
+      } while (!reserve_state_.compare_exchange_weak(
+          state, (((pos + size) & Pos_Mask) << 8) | ((state & 0xFF) + 1),
+          std::memory_order_acquire, std::memory_order_relaxed));
+      return pos;
+    }
+  }
+
+  void commit(uint32_t pos, uint32_t size) {
+    if constexpr (Producers == LogProducers::Single) {
+      commit_pos_.store((pos + size) & Pos_Mask, std::memory_order_release);
+    } else {
+      // Last unfinished writer publishes everything reserved so far
+      auto state = reserve_state_.fetch_sub(1, std::memory_order_acq_rel) - 1;
+      if ((state & 0xFF) != 0) return;
+
+      auto end = state >> 8;
+      auto commit = commit_pos_.load(std::memory_order_relaxed);
+      while (distance(end, commit) != 0 &&
+             distance(end, commit) <= Buffer_Size &&
+             !commit_pos_.compare_exchange_weak(commit, end,
+                                                std::memory_order_release,
+                                                std::memory_order_relaxed)) {
+      }
+    }
+  }
+
+  // Discards oldest unsent lines until size bytes are free
+  bool discard(uint32_t size) {
+    auto send_pos = send_pos_.load(std::memory_order_acquire);
+    if (read_pos_.load(std::memory_order_acquire) != send_pos) return false;
+
+    auto commit_pos = commit_pos_.load(std::memory_order_relaxed);
+    auto free = Buffer_Size - distance(commit_pos, send_pos);
+    auto end = send_pos;
+    uint32_t lines = 0;
+    while (free < size && end != commit_pos) {
+      uint8_t c;
+      do {
+        c = buffer_[end % Buffer_Size];
+        end = (end + 1) & Pos_Mask;
+        ++free;
+      } while (c != '\n' && end != commit_pos);
+      ++lines;
+    }
+
+    if (free < size) return false;
+    if (!send_pos_.compare_exchange_strong(send_pos, end,
+                                           std::memory_order_acq_rel)) {
+      return false;
+    }
+    read_pos_.compare_exchange_strong(send_pos, end, std::memory_order_acq_rel);
+
+    dropped_.fetch_add(lines, std::memory_order_relaxed);
+    dropped_total_.fetch_add(lines, std::memory_order_relaxed);
+    return true;
+  }
 };
 
 }  // namespace m
@@ -0,0 +1,84 @@
+/**
+ * This file is part of m library.
+ *
+ * m library is free software: you can redistribute it and/or modify
+ * it under the terms of the MIT License. See the LICENSE file in the
+ * project root for more information.
+ *
+ * Copyright (c) 2025 Max Melekesov <max.melekesov@gmail.com>
+ */
+
+#ifndef LEVEL_LOG_H
+#define LEVEL_LOG_H
+
+#include <ILog.hpp>
+#include <cstdint>
+#include <string_view>
+#include <type_traits>
+
+namespace m {
+
+// ##################################################
+// Usage Example:
+// constexpr auto Build_Level = m::LogLevel::Info;  // e.g. Warning in release
+// m::LevelLog<Build_Level> modbus_log(uart_log);   // one per module
+// m::LevelLog<m::LogLevel::Debug, true> adc_log(uart_log);
+//
+// modbus_log.add<m::LogLevel::Error>("crc");
+// modbus_log.add<m::LogLevel::Debug>([&] { return format(buf, value); });
+//
+// Sites below Compiled_Level are discarded at compile time, a lambda
+// argument is not even called, so building the text costs nothing.
+// With Runtime_Threshold = true enabled sites additionally compare against
+// a threshold set by setThreshold().
+// ##################################################
+
+enum class LogLevel : uint8_t { Trace, Debug, Info, Warning, Error, Off };
+
+template <LogLevel Compiled_Level = LogLevel::Trace,
+          bool Runtime_Threshold = false>
+class LevelLog {
+ public:
+  LevelLog(ifc::ILog& log) : log_(log) {}
+
+  template <LogLevel Level>
+  static constexpr bool compiled() {
+    return Level != LogLevel::Off && Level >= Compiled_Level;
+  }
+
+  template <LogLevel Level>
+  bool enabled() {
+    if constexpr (!compiled<Level>()) {
+      return false;
+    } else if constexpr (Runtime_Threshold) {
+      return Level >= threshold_;
+    } else {
+      return true;
+    }
+  }
+
+  // Text is std::string_view or a callable returning it
+  template <LogLevel Level, typename Text>
+  void add(Text&& text) {
+    if constexpr (compiled<Level>()) {
+      if (!enabled<Level>()) return;
+
+      if constexpr (std::is_invocable_v<Text>) {
+        log_.add(text());
+      } else {
+        log_.add(text);
+      }
+    }
+  }
+
+  void setThreshold(LogLevel level) { threshold_ = level; }
+  LogLevel getThreshold() { return threshold_; }
+
+ private:
+  ifc::ILog& log_;
+  LogLevel threshold_ = Compiled_Level;
+};
+
+}  // namespace m
+
+#endif  // LEVEL_LOG_H
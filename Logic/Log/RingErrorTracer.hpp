@@ -0,0 +1,147 @@
+/**
+ * This file is part of m library.
+ *
+ * m library is free software: you can redistribute it and/or modify
+ * it under the terms of the MIT License. See the LICENSE file in the
+ * project root for more information.
+ *
+ * Copyright (c) 2025 Max Melekesov <max.melekesov@gmail.com>
+ */
+
+#ifndef RINGERRORTRACER_H
+#define RINGERRORTRACER_H
+
+#include <IErrorTracer.hpp>
+#include <ITime.hpp>
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <optional>
+#include <span>
+
+namespace m {
+
+// Keeps the last Max_Elements errors, oldest entries are overwritten.
+// Consecutive identical errors are folded into one entry with a counter and
+// first/last tick. add() is lock-free and may be called from ISRs and main
+// loop at once (needs atomic read-modify-write, Cortex-M3 and newer),
+// getTrace(), getEntries() and clear() are for a single reader context.
+// T and TimeUnit must fit a lock-free atomic (4 bytes on Cortex-M3/M4),
+// a libatomic lock taken from an ISR may deadlock.
+template <typename T, std::size_t Max_Elements, typename TimeUnit>
+class RingErrorTracer : public m::ifc::IErrorTracer<T> {
+ public:
+  using type = T;
+  using time_type = TimeUnit;
+
+  static_assert(std::atomic<type>::is_always_lock_free &&
+                    std::atomic<time_type>::is_always_lock_free,
+                "T and TimeUnit atomics must be lock-free");
+
+  struct Entry {
+    type value;
+    uint32_t count;
+    time_type first;
+    time_type last;
+  };
+
+  RingErrorTracer(m::ifc::ITime<time_type>& time) : time_(time) {}
+
+  bool add(type value) override {
+    auto tick = time_.getTick();
+
+    auto head = head_.load(std::memory_order_acquire);
+    if (head != 0) {
+      auto& slot = slots_[(head - 1) % Max_Elements];
+      if (slot.seq.load(std::memory_order_acquire) == head &&
+          slot.value.load(std::memory_order_relaxed) == value) {
+        slot.count.fetch_add(1, std::memory_order_relaxed);
+        slot.last.store(tick, std::memory_order_relaxed);
+        return true;
+      }
+    }
+
+    auto pos = head_.fetch_add(1, std::memory_order_acq_rel);
+    auto& slot = slots_[pos % Max_Elements];
+    slot.seq.store(0, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    slot.value.store(value, std::memory_order_relaxed);
+    slot.count.store(1, std::memory_order_relaxed);
+    slot.first.store(tick, std::memory_order_relaxed);
+    slot.last.store(tick, std::memory_order_relaxed);
+    slot.seq.store(pos + 1, std::memory_order_release);
+
+    return true;
+  }
+
+  void clear() override {
+    for (auto& slot : slots_) slot.seq.store(0, std::memory_order_relaxed);
+    head_.store(0, std::memory_order_release);
+  }
+
+  // Error values from oldest to newest, one per folded entry
+  std::span<type> getTrace() override {
+    std::size_t size = 0;
+    forEach([&](const Entry& entry) { trace_[size++] = entry.value; });
+    return std::span<type>{trace_.data(), size};
+  }
+
+  // Copies entries from oldest to newest, returns number of entries
+  std::size_t getEntries(std::span<Entry> entries) {
+    std::size_t size = 0;
+    forEach([&](const Entry& entry) {
+      if (size < entries.size()) entries[size++] = entry;
+    });
+    return size;
+  }
+
+ private:
+  struct Slot {
+    // Position + 1 of the entry in slot, 0 while it is being written
+    std::atomic<uint32_t> seq{0};
+    std::atomic<type> value;
+    std::atomic<uint32_t> count{0};
+    std::atomic<time_type> first;
+    std::atomic<time_type> last;
+  };
+
+  m::ifc::ITime<time_type>& time_;
+
+  std::array<Slot, Max_Elements> slots_;
+  std::atomic<uint32_t> head_{0};
+
+  std::array<type, Max_Elements> trace_;
+
+  template <typename F>
+  void forEach(F&& cb) {
+    uint32_t head = head_.load(std::memory_order_acquire);
+    uint32_t pos = head > Max_Elements ? head - Max_Elements : 0;
+    for (; pos != head; ++pos) {
+      if (auto entry = read(pos)) cb(entry.value());
+    }
+  }
+
+  // Entry is skipped if it was overwritten or is being written right now
+  std::optional<Entry> read(uint32_t pos) {
+    auto& slot = slots_[pos % Max_Elements];
+    if (slot.seq.load(std::memory_order_acquire) != pos + 1) {
+      return std::nullopt;
+    }
+
+    Entry entry{slot.value.load(std::memory_order_relaxed),
+                slot.count.load(std::memory_order_relaxed),
+                slot.first.load(std::memory_order_relaxed),
+                slot.last.load(std::memory_order_relaxed)};
+
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (slot.seq.load(std::memory_order_relaxed) != pos + 1) {
+      return std::nullopt;
+    }
+
+    return entry;
+  }
+};
+
+}  // namespace m
+
+#endif  // RINGERRORTRACER_H
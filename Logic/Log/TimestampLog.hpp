@@ -0,0 +1,159 @@
+/**
+ * This file is part of m library.
+ *
+ * m library is free software: you can redistribute it and/or modify
+ * it under the terms of the MIT License. See the LICENSE file in the
+ * project root for more information.
+ *
+ * Copyright (c) 2025 Max Melekesov <max.melekesov@gmail.com>
+ */
+
+#ifndef TIMESTAMP_LOG_H
+#define TIMESTAMP_LOG_H
+
+#include <ILog.hpp>
+#include <ITime.hpp>
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <string_view>
+#include <tuple>
+
+namespace m {
+
+// ##################################################
+// Usage Example:
+// m::IIO_AsyncLog<1'024, 63, m::LogProducers::Single,
+//                 m::LogOverflow::DropNewest, m::LogFraming::Binary>
+//     uart_log(uart);
+// m::TimestampLog<Ms<uint32_t>, 63> log(uart_log, time_ms);
+// log.add("pump on\n");
+//
+// Record: [varint tick][varint len][text...]. Varint is LEB128, tick field
+// is (value << 1) | absolute: the tick difference to the previous record,
+// or the absolute tick every Sync_Interval records, so the host recovers
+// from records dropped by the sink. IIO_AsyncLog sink needs
+// LogFraming::Binary. Host side uses TimestampLogDecoder.
+// Sink_Line_Length - longest add() the sink takes without cutting it,
+// Line_Length of IIO_AsyncLog. Text is cut to Text_Max so that the
+// whole record fits, 57 bytes of a 63 byte line with 32 bit ticks.
+// ##################################################
+
+template <typename TimeUnit, std::size_t Sink_Line_Length = 63,
+          uint32_t Sync_Interval = 64>
+class TimestampLog : public ifc::ILog {
+ public:
+  using type = TimeUnit;
+
+  static_assert(Sink_Line_Length < 0x4000, "Sink_Line_Length is too big");
+
+  // Tick field has one bit more than the tick, 64 bits at most
+  static constexpr std::size_t Tick_Field_Bits =
+      std::min<std::size_t>(sizeof(typename type::type) * 8 + 1, 64);
+  static constexpr std::size_t Tick_Bytes = (Tick_Field_Bits + 6) / 7;
+  // Varint length takes a second byte from 128 bytes of text on
+  static constexpr std::size_t Len_Bytes =
+      Sink_Line_Length - Tick_Bytes > 128 ? 2 : 1;
+
+  static_assert(Sink_Line_Length > Tick_Bytes + Len_Bytes,
+                "Sink_Line_Length is too small");
+
+  static constexpr std::size_t Text_Max =
+      Sink_Line_Length - Tick_Bytes - Len_Bytes;
+
+  TimestampLog(ifc::ILog& log, ifc::ITime<type>& time)
+      : log_(log), time_(time) {}
+
+  void add(std::string_view text) override {
+    auto tick = time_.getTick();
+
+    uint64_t field;
+    if (records_++ % Sync_Interval == 0) {
+      field = (static_cast<uint64_t>(tick.value()) << 1) | 1;
+    } else {
+      field = static_cast<uint64_t>((tick - prev_tick_).value()) << 1;
+    }
+    prev_tick_ = tick;
+
+    auto data = text.substr(0, Text_Max);
+    std::array<uint8_t, Sink_Line_Length> record;
+    auto size = putVarint(record, field);
+    size += putVarint(std::span(record).subspan(size), data.size());
+    std::ranges::copy(data, record.begin() + size);
+    size += data.size();
+
+    log_.add(
+        std::string_view(reinterpret_cast<const char*>(record.data()), size));
+  }
+
+ private:
+  ifc::ILog& log_;
+  ifc::ITime<type>& time_;
+
+  type prev_tick_{0};
+  uint32_t records_ = 0;
+
+  static std::size_t putVarint(std::span<uint8_t> data, uint64_t value) {
+    std::size_t size = 0;
+    while (value >= 0x80) {
+      data[size++] = static_cast<uint8_t>(value) | 0x80;
+      value >>= 7;
+    }
+    data[size++] = static_cast<uint8_t>(value);
+    return size;
+  }
+};
+
+// Host side part of TimestampLog.
+// Tick_Bits - width of the device tick counter, e.g. 16 for Us<uint16_t>
+template <uint32_t Tick_Bits = 32>
+class TimestampLogDecoder {
+ public:
+  static_assert(Tick_Bits > 0 && Tick_Bits < 64, "Wrong Tick_Bits");
+
+  // Decodes the record at the start of data.
+  // Returns {consumed bytes, absolute tick, text}, nullopt if incomplete.
+  // Tick counts from the last absolute record, ticks before the first one
+  // are relative to the start of decoding.
+  std::optional<std::tuple<std::size_t, uint64_t, std::string_view>> decode(
+      std::span<uint8_t const> data) {
+    std::size_t pos = 0;
+    auto field = getVarint(data, pos);
+    if (!field) return std::nullopt;
+    auto len = getVarint(data, pos);
+    if (!len || data.size() - pos < len.value()) return std::nullopt;
+
+    if (field.value() & 1) {
+      // Keep the running tick monotonic across counter wraps
+      tick_ += ((field.value() >> 1) - tick_) & Tick_Mask;
+    } else {
+      tick_ += field.value() >> 1;
+    }
+
+    std::string_view text(reinterpret_cast<const char*>(data.data() + pos),
+                          len.value());
+    return std::tuple{pos + len.value(), tick_, text};
+  }
+
+ private:
+  static constexpr uint64_t Tick_Mask = (uint64_t{1} << Tick_Bits) - 1;
+
+  uint64_t tick_ = 0;
+
+  static std::optional<uint64_t> getVarint(std::span<uint8_t const> data,
+                                           std::size_t& pos) {
+    uint64_t value = 0;
+    for (uint32_t shift = 0; pos < data.size() && shift < 64; shift += 7) {
+      auto byte = data[pos++];
+      value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+      if (!(byte & 0x80)) return value;
+    }
+    return std::nullopt;
+  }
+};
+
+}  // namespace m
+
+#endif  // TIMESTAMP_LOG_H
@@ -14,8 +14,10 @@
 #include <IDataLink.hpp>
 #include <IIO_Async.hpp>
 #include <Timer.hpp>
+#include <algorithm>
 #include <cstdint>
 #include <cstring>
+#include <functional>
 #include <optional>
 #include <span>
 
@@ -31,10 +33,16 @@ class DataLinkAsync : public ifc::IDataLink {
     type packet_rx_time_between_bytes{0};
   };
 
+  // Returns true if received frame is valid (e.g. CRC matches)
+  using FrameCheck = std::function<bool(std::span<uint8_t const> frame)>;
+
  public:
   DataLinkAsync(ifc::ITime<type> &time, ifc::IIO_Async &io, Timings timings)
-      : io_(io), rx_between_bytes_timer_{time}, tx_timeout_timer_{time} {
-    rx_between_bytes_timer_.restart(timings.packet_rx_time_between_bytes);
+      : io_(io),
+        rx_between_bytes_timer_{time},
+        tx_timeout_timer_{time},
+        frame_gap_(timings.packet_rx_time_between_bytes) {
+    rx_between_bytes_timer_.restart(frame_gap_);
   }
 
   bool startReceive(std::span<uint8_t> rx_buf) override {
@@ -53,32 +61,26 @@ class DataLinkAsync : public ifc::IDataLink {
   }
 
   std::optional<uint32_t> getRxPacketSize() override {
-    auto bytes = io_.bytesAvailable();
-    if (bytes == rx_buf_.size()) {
-      if (io_.readDone())
-        return rx_buf_.size();
-      else
-        return std::nullopt;
-    } else {
-      if (bytes != 0) {
-        if (bytes == bytes_start_count_) {
-          if (rx_between_bytes_timer_.timeOver()) {
-            if (!io_.abortRead()) {
-              return std::nullopt;
-            } else {
-              return bytes;
-            }
-          }
-        } else {
-          bytes_start_count_ = bytes;
-          rx_between_bytes_timer_.reset();
-        }
-      }
+    auto size = rxPacketSize();
+    if (!size || !auto_baud_.check) return size;
+
+    if (auto_baud_.check(rx_buf_.first(size.value()))) {
+      stopAutoBaud();
+      detected_baud_ = io_.getBaudrate();
+      return size;
     }
 
+    if (++auto_baud_.bad_frames >= auto_baud_.max_bad_frames) {
+      nextBaudrate();
+    }
+    // Reported by error(), so the owner restarts reception
+    if (!startReceive(rx_buf_)) rx_restart_failed_ = true;
+
     return std::nullopt;
   }
 
+  bool rxPending() override { return io_.bytesAvailable() != 0; }
+
   bool startTransmit(std::span<uint8_t> tx_buf) override {
     if (!io_.abortWrite()) {
       return false;
@@ -109,7 +111,19 @@ class DataLinkAsync : public ifc::IDataLink {
     return std::nullopt;
   }
 
-  bool error() override { return io_.error(); }
+  bool error() override {
+    if (rx_restart_failed_) {
+      rx_restart_failed_ = false;
+      return true;
+    }
+    if (!io_.error()) return false;
+    // Framing errors are expected on a wrong baudrate
+    if (auto_baud_.check &&
+        ++auto_baud_.bad_frames >= auto_baud_.max_bad_frames) {
+      nextBaudrate();
+    }
+    return true;
+  }
 
   bool reset() override {
     if (!io_.abortWrite()) {
@@ -121,14 +135,96 @@ class DataLinkAsync : public ifc::IDataLink {
     return true;
   }
 
+  // Cycle through rates until check accepts a received frame, the frame
+  // gap follows the rate being tried, the one from Timings is restored
+  // when auto-baud stops
+  bool startAutoBaud(std::span<uint32_t const> rates, FrameCheck &&check,
+                     uint8_t max_bad_frames = 2) {
+    if (rates.empty() || !check || max_bad_frames == 0) return false;
+    if (!io_.setBaudrate(rates[0])) return false;
+
+    auto_baud_ = AutoBaud{rates, std::move(check), 0, 0, max_bad_frames};
+    detected_baud_ = std::nullopt;
+    setFrameGap(rates[0]);
+
+    return true;
+  }
+
+  void stopAutoBaud() {
+    auto_baud_.check = nullptr;
+    rx_between_bytes_timer_.restart(frame_gap_);
+  }
+
+  bool autoBaudRunning() { return static_cast<bool>(auto_baud_.check); }
+
+  std::optional<uint32_t> getDetectedBaudrate() { return detected_baud_; }
+
  private:
   ifc::IIO_Async &io_;
 
   Timer<type> rx_between_bytes_timer_;
   Timer<type> tx_timeout_timer_;
+  type const frame_gap_;
 
   uint32_t bytes_start_count_ = 0;
   std::span<uint8_t> rx_buf_;
+  bool rx_restart_failed_ = false;
+
+  struct AutoBaud {
+    std::span<uint32_t const> rates;
+    FrameCheck check;
+    std::size_t index = 0;
+    uint8_t bad_frames = 0;
+    uint8_t max_bad_frames = 1;
+  };
+  AutoBaud auto_baud_;
+  std::optional<uint32_t> detected_baud_;
+
+  std::optional<uint32_t> rxPacketSize() {
+    auto bytes = io_.bytesAvailable();
+    if (bytes == rx_buf_.size()) {
+      if (io_.readDone())
+        return rx_buf_.size();
+      else
+        return std::nullopt;
+    } else {
+      if (bytes != 0) {
+        if (bytes == bytes_start_count_) {
+          if (rx_between_bytes_timer_.timeOver()) {
+            if (!io_.abortRead()) {
+              return std::nullopt;
+            } else {
+              return bytes;
+            }
+          }
+        } else {
+          bytes_start_count_ = bytes;
+          rx_between_bytes_timer_.reset();
+        }
+      }
+    }
+
+    return std::nullopt;
+  }
+
+  void nextBaudrate() {
+    auto_baud_.index = (auto_baud_.index + 1) % auto_baud_.rates.size();
+    auto_baud_.bad_frames = 0;
+    auto baud = auto_baud_.rates[auto_baud_.index];
+    if (!io_.setBaudrate(baud)) {
+      stopAutoBaud();
+      return;
+    }
+    setFrameGap(baud);
+  }
+
+  // 3.5 characters of 11 bits, fixed 1750 us above 19200 baud as Modbus
+  // RTU requires; TimeUnit is us as in startTransmit()
+  void setFrameGap(uint32_t baud) {
+    auto gap = 38'500'000 / baud;
+    if (baud > 19'200) gap = std::max<uint32_t>(gap, 1'750);
+    rx_between_bytes_timer_.restart(type{gap});
+  }
 };
 
 }  // namespace m
@@ -203,6 +203,28 @@ class ModbusRtuProtocol {
 
   uint8_t getAddress() { return addr_; }
 
+  // Frame CRC check, usable as DataLinkAsync::FrameCheck for auto-baud
+  static bool checkFrame(std::span<uint8_t const> frame) {
+    if (frame.size() < 4) return false;
+    uint16_t lo = frame.last(2)[0];
+    uint16_t hi = frame.last(2)[1];
+    return crc16(frame.first(frame.size() - 2)) == lo + (hi << 8);
+  }
+
+  // Port has work to do now: a reception to start, received bytes or a
+  // response being transmitted. Does not change the data link state.
+  bool busy() {
+    switch (state_) {
+      case State::Idle:
+        return running_;
+      case State::ProcessPacket:
+        return data_link_.rxPending();
+      case State::TransmitResponse:
+        return true;
+    }
+    return false;
+  }
+
  private:
   m::ifc::IDataLink &data_link_;
   m::ifc::ITime<type> &time_;
@@ -688,7 +710,7 @@ class ModbusRtuProtocol {
 
   uint16_t byteswap(uint16_t value) { return (value >> 8) | (value << 8); }
 
-  uint16_t crc16(std::span<uint8_t> data) {
+  static uint16_t crc16(std::span<uint8_t const> data) {
     static const uint16_t table[2] = {0x00'00, 0xA0'01};
     uint16_t crc = 0xFF'FF;
     uint16_t xorv = 0;
@@ -0,0 +1,124 @@
+/**
+ * This file is part of m library.
+ *
+ * m library is free software: you can redistribute it and/or modify
+ * it under the terms of the MIT License. See the LICENSE file in the
+ * project root for more information.
+ *
+ * Copyright (c) 2025 Max Melekesov <max.melekesov@gmail.com>
+ */
+
+#ifndef PROTOCOL_MUX_H
+#define PROTOCOL_MUX_H
+
+#include <ITime.hpp>
+#include <ModbusRtuProtocol.hpp>
+#include <array>
+#include <cstdint>
+#include <optional>
+
+namespace m {
+
+// Services several protocol instances (one per data link) from the main loop.
+// RoundRobin - every port once per handle(), start port rotates.
+// Weighted - busy ports (received bytes, reception to start, response in
+// flight) every handle(), plus up to `budget` idle ports picked by smooth
+// weighted round-robin. An idle port costs one busy() check, so idle ports
+// add almost nothing to the latency of the busy ones.
+template <typename TimeUnit, std::size_t Max_Ports>
+class ProtocolMux {
+ public:
+  using type = TimeUnit;
+
+  enum class Mode : uint8_t { RoundRobin, Weighted };
+
+  struct Settings {
+    Mode mode = Mode::RoundRobin;
+    std::size_t budget = 1;
+  };
+
+  struct Stats {
+    type last_service{0};
+    type max_service{0};
+    uint32_t calls = 0;
+  };
+
+  ProtocolMux(m::ifc::ITime<type> &time, Settings settings)
+      : time_(time), st_(settings) {}
+
+  std::optional<std::size_t> addPort(ModbusRtuProtocol<type> &protocol,
+                                     uint8_t weight = 1) {
+    if (ports_num_ >= Max_Ports || weight == 0) return std::nullopt;
+    ports_[ports_num_] = Port{&protocol, weight, 0, {}};
+    total_weight_ += weight;
+    return ports_num_++;
+  }
+
+  void handle() {
+    if (ports_num_ == 0) return;
+
+    if (st_.mode == Mode::RoundRobin) {
+      for (std::size_t i = 0; i < ports_num_; ++i) {
+        service(ports_[(next_ + i) % ports_num_]);
+      }
+      next_ = (next_ + 1) % ports_num_;
+      return;
+    }
+
+    for (std::size_t i = 0; i < ports_num_; ++i) {
+      if (ports_[i].protocol->busy()) service(ports_[i]);
+    }
+
+    for (std::size_t n = 0; n < st_.budget; ++n) {
+      Port *pick = nullptr;
+      for (std::size_t i = 0; i < ports_num_; ++i) {
+        auto &port = ports_[i];
+        port.current += port.weight;
+        if (!pick || port.current > pick->current) pick = &port;
+      }
+      pick->current -= total_weight_;
+      if (!pick->protocol->busy()) service(*pick);
+    }
+  }
+
+  std::optional<Stats> getStats(std::size_t port) {
+    if (port >= ports_num_) return std::nullopt;
+    return ports_[port].stats;
+  }
+
+  void resetStats() {
+    for (std::size_t i = 0; i < ports_num_; ++i) ports_[i].stats = Stats{};
+  }
+
+  std::size_t size() { return ports_num_; }
+
+ private:
+  struct Port {
+    ModbusRtuProtocol<type> *protocol;
+    uint8_t weight;
+    int32_t current;
+    Stats stats;
+  };
+
+  m::ifc::ITime<type> &time_;
+  Settings st_;
+
+  std::array<Port, Max_Ports> ports_;
+  std::size_t ports_num_ = 0;
+  std::size_t next_ = 0;
+  int32_t total_weight_ = 0;
+
+  void service(Port &port) {
+    auto start = time_.getTick();
+    port.protocol->handle();
+    auto spent = time_.getDiff(start);
+
+    port.stats.last_service = spent;
+    if (spent > port.stats.max_service) port.stats.max_service = spent;
+    ++port.stats.calls;
+  }
+};
+
+}  // namespace m
+
+#endif  // PROTOCOL_MUX_H
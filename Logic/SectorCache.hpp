@@ -0,0 +1,161 @@
+/**
+ * This file is part of m library.
+ *
+ * m library is free software: you can redistribute it and/or modify
+ * it under the terms of the MIT License. See the LICENSE file in the
+ * project root for more information.
+ *
+ * Copyright (c) 2025 Max Melekesov <max.melekesov@gmail.com>
+ */
+
+#ifndef SECTORCACHE_H
+#define SECTORCACHE_H
+
+#include <IMemory.hpp>
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <span>
+
+namespace m {
+
+// Write-back cache of Sectors_Num sectors in RAM on top of any IMemory.
+// Writes are merged in RAM and reach the memory on flush() or when the
+// least recently used sector is evicted. Reads are served from cached
+// sectors, missed reads go to the memory without loading a sector.
+// Data written since the last flush() is lost on reset. The last sector
+// may be cut short by the memory size, it is loaded and flushed only up
+// to the end of the memory.
+template <std::size_t Sectors_Num, std::size_t Sector_Size = 4'096>
+class SectorCache : public ifc::IMemory {
+ public:
+  SectorCache(ifc::IMemory& mem) : mem_(mem) {}
+
+  std::size_t size() override { return mem_.size(); }
+
+  bool write(std::size_t addr, std::span<uint8_t const> data) override {
+    if (!inside(addr, data.size())) return false;
+
+    while (data.size() != 0) {
+      auto offset = addr % Sector_Size;
+      auto size = std::min(Sector_Size - offset, data.size());
+      auto line = find(addr - offset);
+      if (!line) {
+        line = allocate(addr - offset, size == lineSize(addr - offset));
+        if (!line) return false;
+      }
+
+      std::ranges::copy(data.first(size), line->data.begin() + offset);
+      line->dirty = true;
+
+      addr += size;
+      data = data.subspan(size);
+    }
+
+    return true;
+  }
+
+  bool read(std::size_t addr, std::span<uint8_t> data) override {
+    if (!inside(addr, data.size())) return false;
+
+    while (data.size() != 0) {
+      auto offset = addr % Sector_Size;
+      auto size = std::min(Sector_Size - offset, data.size());
+      if (auto line = find(addr - offset)) {
+        std::copy_n(line->data.begin() + offset, size, data.begin());
+      } else if (!mem_.read(addr, data.first(size))) {
+        return false;
+      }
+
+      addr += size;
+      data = data.subspan(size);
+    }
+
+    return true;
+  }
+
+  // Writes all changed sectors to the memory
+  bool flush() {
+    for (auto& line : lines_) {
+      if (line.valid && line.dirty) {
+        if (!writeLine(line)) return false;
+        line.dirty = false;
+      }
+    }
+    return true;
+  }
+
+  uint32_t getHits() { return hits_; }
+  uint32_t getMisses() { return misses_; }
+
+  void resetStats() {
+    hits_ = 0;
+    misses_ = 0;
+  }
+
+ private:
+  struct Line {
+    std::size_t addr = 0;
+    uint32_t used = 0;
+    bool valid = false;
+    bool dirty = false;
+    std::array<uint8_t, Sector_Size> data;
+  };
+
+  ifc::IMemory& mem_;
+
+  std::array<Line, Sectors_Num> lines_;
+  uint32_t use_counter_ = 0;
+  uint32_t hits_ = 0;
+  uint32_t misses_ = 0;
+
+  bool inside(std::size_t addr, std::size_t size) {
+    return addr <= mem_.size() && size <= mem_.size() - addr;
+  }
+
+  std::size_t lineSize(std::size_t addr) {
+    return std::min(Sector_Size, mem_.size() - addr);
+  }
+
+  bool writeLine(Line& line) {
+    return mem_.write(line.addr,
+                      std::span(line.data).first(lineSize(line.addr)));
+  }
+
+  Line* find(std::size_t addr) {
+    for (auto& line : lines_) {
+      if (line.valid && line.addr == addr) {
+        line.used = ++use_counter_;
+        ++hits_;
+        return &line;
+      }
+    }
+    ++misses_;
+    return nullptr;
+  }
+
+  // Evicts the least recently used sector, whole sector writes skip loading
+  Line* allocate(std::size_t addr, bool whole) {
+    auto& line = *std::ranges::min_element(lines_, [](auto& a, auto& b) {
+      if (a.valid != b.valid) return !a.valid;
+      return a.used < b.used;
+    });
+
+    if (line.valid && line.dirty) {
+      if (!writeLine(line)) return nullptr;
+    }
+    line.valid = false;
+
+    auto data = std::span(line.data).first(lineSize(addr));
+    if (!whole && !mem_.read(addr, data)) return nullptr;
+
+    line.addr = addr;
+    line.used = ++use_counter_;
+    line.valid = true;
+    line.dirty = false;
+    return &line;
+  }
+};
+}  // namespace m
+
+#endif  // SECTORCACHE_H
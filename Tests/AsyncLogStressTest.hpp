@@ -0,0 +1,116 @@
+/**
+ * This file is part of m library.
+ *
+ * m library is free software: you can redistribute it and/or modify
+ * it under the terms of the MIT License. See the LICENSE file in the
+ * project root for more information.
+ *
+ * Copyright (c) 2025 Max Melekesov <max.melekesov@gmail.com>
+ */
+
+#ifndef ASYNCLOGSTRESSTEST_H
+#define ASYNCLOGSTRESSTEST_H
+
+#include <IIO_Async.hpp>
+#include <IIO_AsyncLog.hpp>
+#include <array>
+#include <atomic>
+#include <charconv>
+#include <cstdint>
+#include <string_view>
+#include <thread>
+
+namespace m::tsts {
+
+// Host only. Threads stand in for ISRs: every producer logs "<id>:<seq>;"
+// while the consumer thread runs handle(). Lines may be dropped when the
+// ring is full (and reported by a marker line), but every received line
+// must be whole and in order.
+template <LogProducers Producers, uint32_t Producers_Num,
+          uint32_t Lines_Per_Producer>
+bool asyncLogStressTest() {
+  static_assert(Producers == LogProducers::Multi || Producers_Num == 1,
+                "Single mode allows one producer");
+
+  class Sink : public ifc::IIO_Async {
+   public:
+    std::array<char, Producers_Num * Lines_Per_Producer * 16> out;
+    std::size_t size = 0;
+
+    uint32_t bytesToWrite() override { return 0; }
+    bool writeAsync(std::span<uint8_t const> data) override {
+      if (size + data.size() > out.size()) return false;
+      for (auto c : data) out[size++] = c;
+      return true;
+    }
+    bool abortWrite() override { return true; }
+    bool writeDone() override { return true; }
+
+    uint32_t bytesAvailable() override { return 0; }
+    bool readAsync(std::span<uint8_t>) override { return false; }
+    bool abortRead() override { return true; }
+    bool readDone() override { return true; }
+
+    uint32_t getBaudrate() override { return 0; }
+    bool error() override { return false; }
+  };
+
+  Sink sink;
+  IIO_AsyncLog<256, 15, Producers> log(sink);
+  std::atomic<uint32_t> running{Producers_Num};
+
+  std::array<std::thread, Producers_Num> producers;
+  for (uint32_t id = 0; id < Producers_Num; ++id) {
+    producers[id] = std::thread([&log, &running, id]() {
+      for (uint32_t seq = 0; seq < Lines_Per_Producer; ++seq) {
+        std::array<char, 16> line;
+        auto* p = std::to_chars(line.data(), line.data() + 4, id).ptr;
+        *p++ = ':';
+        p = std::to_chars(p, line.data() + 14, seq).ptr;
+        *p++ = ';';
+        log.add(std::string_view(line.data(), p - line.data()));
+        if (seq % 64 == 0) std::this_thread::yield();
+      }
+      --running;
+    });
+  }
+
+  while (running) log.handle();
+  for (auto& t : producers) t.join();
+  for (auto i = 0; i < 3; ++i) log.handle();
+
+  if (sink.size == 0) return false;
+
+  std::array<int64_t, Producers_Num> last;
+  last.fill(-1);
+  std::string_view out(sink.out.data(), sink.size);
+  while (!out.empty()) {
+    if (out.front() == '[') {
+      auto marker_end = out.find('\n');
+      if (marker_end == std::string_view::npos) return false;
+      out.remove_prefix(marker_end + 1);
+      continue;
+    }
+
+    auto end = out.find(';');
+    if (end == std::string_view::npos) return false;
+    auto line = out.substr(0, end);
+    out.remove_prefix(end + 1);
+
+    auto colon = line.find(':');
+    if (colon == std::string_view::npos) return false;
+    uint32_t id = 0, seq = 0;
+    auto [p1, ec1] = std::from_chars(line.data(), line.data() + colon, id);
+    auto [p2, ec2] =
+        std::from_chars(line.data() + colon + 1, line.data() + end, seq);
+    if (ec1 != std::errc{} || p1 != line.data() + colon) return false;
+    if (ec2 != std::errc{} || p2 != line.data() + end) return false;
+    if (id >= Producers_Num || seq <= last[id]) return false;
+    last[id] = seq;
+  }
+
+  return true;
+}
+}  // namespace m::tsts
+
+#endif  // ASYNCLOGSTRESSTEST_H
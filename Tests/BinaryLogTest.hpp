@@ -0,0 +1,101 @@
+/**
+ * This file is part of m library.
+ *
+ * m library is free software: you can redistribute it and/or modify
+ * it under the terms of the MIT License. See the LICENSE file in the
+ * project root for more information.
+ *
+ * Copyright (c) 2025 Max Melekesov <max.melekesov@gmail.com>
+ */
+
+#ifndef BINARYLOGTEST_H
+#define BINARYLOGTEST_H
+
+#include <BinaryLog.hpp>
+#include <BinaryLogDecoder.hpp>
+#include <IIO_Async.hpp>
+#include <IIO_AsyncLog.hpp>
+#include <array>
+#include <cstdint>
+#include <cstdio>
+#include <string_view>
+
+namespace m::tsts {
+
+// Host only. Records go BinaryLog -> IIO_AsyncLog (Binary framing) ->
+// BinaryLogDecoder, every decoded line must equal snprintf of the same
+// format and values. The longest record fills a whole sink line.
+inline bool binaryLogTest() {
+  class Sink : public ifc::IIO_Async {
+   public:
+    std::array<uint8_t, 512> out;
+    std::size_t size = 0;
+
+    uint32_t bytesToWrite() override { return 0; }
+    bool writeAsync(std::span<uint8_t const> data) override {
+      if (size + data.size() > out.size()) return false;
+      for (auto c : data) out[size++] = c;
+      return true;
+    }
+    bool abortWrite() override { return true; }
+    bool writeDone() override { return true; }
+
+    uint32_t bytesAvailable() override { return 0; }
+    bool readAsync(std::span<uint8_t>) override { return false; }
+    bool abortRead() override { return true; }
+    bool readDone() override { return true; }
+
+    uint32_t getBaudrate() override { return 0; }
+    bool error() override { return false; }
+  };
+
+  using Formats = LogFormats<"boot", "temp=%.1f adc=%u", "%d %lld %llx %c",
+                             "%5.2f|%-4d|%%|%ld|%zu|%hhd",
+                             "%llu %llu %llu %llu %llu %llu %llu">;
+  constexpr std::size_t Line_Length = 3 + 7 * 8;
+
+  Sink sink;
+  IIO_AsyncLog<1'024, Line_Length, LogProducers::Single,
+               LogOverflow::DropNewest, LogFraming::Binary>
+      log(sink);
+  BinaryLog<Formats, Line_Length> blog(log);
+
+  std::array<std::array<char, 96>, 5> expected;
+  auto print = [&](std::size_t i, char const* fmt, auto... args) {
+    std::snprintf(expected[i].data(), expected[i].size(), fmt, args...);
+  };
+
+  blog.add<"boot">();
+  print(0, "boot");
+  blog.add<"temp=%.1f adc=%u">(25.5f, 1'234u);
+  print(1, "temp=%.1f adc=%u", 25.5, 1'234u);
+  blog.add<"%d %lld %llx %c">(-5, -1LL << 40, 0xDEAD'BEEF'CAFEULL, 'x');
+  print(2, "%d %lld %llx %c", -5, -1LL << 40, 0xDEAD'BEEF'CAFEULL, 'x');
+  blog.add<"%5.2f|%-4d|%%|%ld|%zu|%hhd">(3.14159f, 7, -100'000L,
+                                          std::size_t{42}, 300);
+  print(3, "%5.2f|%-4d|%%|%ld|%zu|%hhd", 3.14159f, 7, -100'000L,
+        std::size_t{42}, 300);
+  blog.add<"%llu %llu %llu %llu %llu %llu %llu">(1ULL, 2ULL, 3ULL, 4ULL,
+                                                  5ULL, 6ULL, ~0ULL);
+  print(4, "%llu %llu %llu %llu %llu %llu %llu", 1ULL, 2ULL, 3ULL, 4ULL,
+        5ULL, 6ULL, ~0ULL);
+
+  log.handle();
+  if (log.getDropped() != 0) return false;
+
+  BinaryLogDecoder<Formats> decoder;
+  auto data = std::span<uint8_t const>(sink.out.data(), sink.size);
+  for (auto& line : expected) {
+    std::array<char, 96> text;
+    auto result = decoder.decode(data, text);
+    if (!result) return false;
+    auto [consumed, len] = result.value();
+    if (std::string_view(text.data(), len) != line.data()) return false;
+    data = data.subspan(consumed);
+  }
+
+  return data.empty();
+}
+}  // namespace m::tsts
+
+#endif  // BINARYLOGTEST_H
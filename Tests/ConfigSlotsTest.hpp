@@ -0,0 +1,85 @@
+/**
+ * This file is part of m library.
+ *
+ * m library is free software: you can redistribute it and/or modify
+ * it under the terms of the MIT License. See the LICENSE file in the
+ * project root for more information.
+ *
+ * Copyright (c) 2025 Max Melekesov <max.melekesov@gmail.com>
+ */
+
+#ifndef CONFIGSLOTSTEST_H
+#define CONFIGSLOTSTEST_H
+
+#include <ConfigSlots.hpp>
+#include <IMemory.hpp>
+#include <PowerCut.hpp>
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstdlib>
+#include <optional>
+
+namespace m::tsts {
+
+// Iterations writes of 1..Max_Size bytes, each one cut off by power loss
+// after a random budget. After every cut the slots are mounted again and
+// must hold the old or the new config, only the new one if write()
+// returned true. Nothing is valid before the first completed write.
+template <std::size_t Max_Size, uint32_t Iterations,
+          std::size_t Sector_Size = 4'096>
+bool configSlotsPowerCutTest(ifc::IMemory& mem) {
+  using Slots = ConfigSlots<Sector_Size>;
+
+  struct Config {
+    std::size_t size = 0;
+    std::array<uint8_t, Max_Size> data{};
+    bool operator==(Config const&) const = default;
+  };
+
+  std::srand(0x12'34'56'78);
+
+  PowerCutMemory cut(mem);
+  std::optional<Config> expected;
+
+  auto read = [](Slots& slots) -> std::optional<Config> {
+    Config config;
+    if (!slots.init()) return std::nullopt;
+    auto size = slots.read(config.data);
+    if (!size) return std::nullopt;
+    config.size = size.value();
+    return config;
+  };
+
+  expected = [&] {
+    Slots slots(mem);
+    return read(slots);
+  }();
+
+  for (uint32_t i = 0; i < Iterations; ++i) {
+    Config config;
+    config.size = 1 + std::rand() % Max_Size;
+    for (auto& v : std::span(config.data).first(config.size)) {
+      v = std::rand() % 255;
+    }
+
+    bool done;
+    {
+      Slots slots(cut);
+      read(slots);
+      cut.cut(std::rand() % (2 * (Max_Size + Slots::Header_Size)));
+      done = slots.write(std::span(config.data).first(config.size));
+      cut.restore();
+    }
+
+    Slots slots(cut);
+    auto actual = read(slots);
+    if (actual != config && (done || actual != expected)) return false;
+    expected = actual;
+  }
+
+  return true;
+}
+}  // namespace m::tsts
+
+#endif  // CONFIGSLOTSTEST_H
@@ -0,0 +1,81 @@
+/**
+ * This file is part of m library.
+ *
+ * m library is free software: you can redistribute it and/or modify
+ * it under the terms of the MIT License. See the LICENSE file in the
+ * project root for more information.
+ *
+ * Copyright (c) 2025 Max Melekesov <max.melekesov@gmail.com>
+ */
+
+#ifndef FLASHFTLBENCH_H
+#define FLASHFTLBENCH_H
+
+#include <FlashFtl.hpp>
+#include <IFlashMemory.hpp>
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstdlib>
+
+namespace m::tsts {
+
+// ##################################################
+// Usage Example:
+// m::tsts::SpiNorSim<uint32_t> sim(16 * 1024 * 1024);
+// sim.open();
+// static std::array<uint8_t, 4'096> scratch;
+// m::ic::SpiNor<uint32_t> flash(sim, sim, sim, scratch);
+// flash.init();
+// auto result = m::tsts::flashFtlBench<64, 3'000>(flash.flash(), 0);
+// double wa = double(result.flash_bytes) / result.host_bytes;
+// ##################################################
+
+struct FlashFtlBenchResult {
+  bool ok;                // Every write read back, also after remount
+  uint64_t host_bytes;    // getHostBytes()
+  uint64_t flash_bytes;   // getFlashBytes(), flash / host is the WA
+  uint32_t erase_spread;  // getEraseSpread()
+};
+
+// Iterations writes of 1..64 bytes, three of four go to the first 256
+// bytes (hot config) and the rest anywhere. handle() is called after every
+// third write as an idle loop would.
+template <std::size_t Sectors_Num, uint32_t Iterations>
+FlashFtlBenchResult flashFtlBench(ifc::IFlashMemory& flash,
+                                  std::size_t offset) {
+  std::srand(0x12'34'56'78);
+
+  FlashFtl<Sectors_Num> ftl(flash, offset);
+  FlashFtlBenchResult result{ftl.init(), 0, 0, 0};
+
+  std::array<uint8_t, 64> data;
+  std::array<uint8_t, 64> back;
+  std::size_t addr = 0;
+  std::size_t size = 0;
+  for (uint32_t i = 0; i < Iterations && result.ok; ++i) {
+    size = 1 + std::rand() % data.size();
+    addr = std::rand() % (i % 4 != 0 ? 256 : ftl.size() - data.size());
+    for (auto& v : data) v = std::rand() % 255;
+
+    auto written = std::span(data).first(size);
+    auto read = std::span(back).first(size);
+    result.ok = ftl.write(addr, written) && ftl.read(addr, read) &&
+                std::ranges::equal(written, read);
+    if (i % 3 == 0) ftl.handle();
+  }
+
+  result.host_bytes = ftl.getHostBytes();
+  result.flash_bytes = ftl.getFlashBytes();
+  result.erase_spread = ftl.getEraseSpread();
+
+  FlashFtl<Sectors_Num> remount(flash, offset);
+  auto read = std::span(back).first(size);
+  result.ok = result.ok && remount.init() && remount.read(addr, read) &&
+              std::ranges::equal(std::span(data).first(size), read);
+
+  return result;
+}
+}  // namespace m::tsts
+
+#endif  // FLASHFTLBENCH_H
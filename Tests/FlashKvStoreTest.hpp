@@ -0,0 +1,100 @@
+/**
+ * This file is part of m library.
+ *
+ * m library is free software: you can redistribute it and/or modify
+ * it under the terms of the MIT License. See the LICENSE file in the
+ * project root for more information.
+ *
+ * Copyright (c) 2025 Max Melekesov <max.melekesov@gmail.com>
+ */
+
+#ifndef FLASHKVSTORETEST_H
+#define FLASHKVSTORETEST_H
+
+#include <FlashKvStore.hpp>
+#include <IFlashMemory.hpp>
+#include <PowerCut.hpp>
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstdlib>
+#include <optional>
+
+namespace m::tsts {
+
+// Iterations writes and removes of random keys, each one cut off by power
+// loss after a random budget, about half of the compactions are torn too.
+// A torn program may leave its header erased and the bytes after it dirty.
+// The cut call is followed by one more write in the same session, which
+// must succeed. Then the store is mounted again: the cut key must hold its
+// old or new value (only the new one if the call returned true), the
+// second key its new value, the other keys must not change.
+// The region is erased first and must be sector aligned.
+template <std::size_t Max_Keys, std::size_t Max_Value, uint32_t Iterations>
+bool flashKvStorePowerCutTest(ifc::IFlashMemory& flash, std::size_t offset,
+                              std::size_t size) {
+  using Store = FlashKvStore<Max_Keys, Max_Value>;
+  using Value = std::optional<std::array<uint8_t, Max_Value>>;
+  constexpr std::size_t Compaction = Max_Keys * (Max_Value + 8) + 16;
+
+  std::srand(0x12'34'56'78);
+  if (!flash.erase(offset, size)) return false;
+
+  PowerCutFlash cut(flash);
+  std::array<Value, Max_Keys> expected;
+
+  auto read = [](Store& store, uint16_t key) -> Value {
+    std::array<uint8_t, Max_Value> data;
+    if (store.read(key, data) != Max_Value) return std::nullopt;
+    return data;
+  };
+
+  // Random value, one in eight is a remove
+  auto random = []() -> Value {
+    if (std::rand() % 8 == 0) return std::nullopt;
+    std::array<uint8_t, Max_Value> data;
+    for (auto& v : data) v = std::rand() % 255;
+    return data;
+  };
+
+  auto apply = [](Store& store, uint16_t key, Value const& value) {
+    return value ? store.write(key, value.value()) : store.remove(key);
+  };
+
+  for (uint32_t i = 0; i < Iterations; ++i) {
+    uint16_t key = std::rand() % Max_Keys;
+    auto value = random();
+    uint16_t next_key = std::rand() % Max_Keys;
+    auto next_value = random();
+
+    bool done;
+    {
+      Store store(cut, offset, size);
+      if (!store.init()) return false;
+      cut.cut(std::rand() % (2 * Compaction), std::rand() % 8);
+      done = apply(store, key, value);
+      cut.restore();
+      if (!apply(store, next_key, next_value)) return false;
+    }
+
+    Store store(cut, offset, size);
+    if (!store.init()) return false;
+    for (uint16_t k = 0; k < Max_Keys; ++k) {
+      auto actual = read(store, k);
+      if (k == next_key) {
+        if (actual != next_value) return false;
+      } else if (k != key) {
+        if (actual != expected[k]) return false;
+      } else if (actual != value && (done || actual != expected[k])) {
+        return false;
+      }
+    }
+    expected[key] = read(store, key);
+    expected[next_key] = next_value;
+  }
+
+  return true;
+}
+}  // namespace m::tsts
+
+#endif  // FLASHKVSTORETEST_H
@@ -0,0 +1,66 @@
+/**
+ * This file is part of m library.
+ *
+ * m library is free software: you can redistribute it and/or modify
+ * it under the terms of the MIT License. See the LICENSE file in the
+ * project root for more information.
+ *
+ * Copyright (c) 2025 Max Melekesov <max.melekesov@gmail.com>
+ */
+
+#ifndef FLASHREADBENCH_H
+#define FLASHREADBENCH_H
+
+#include <ITime.hpp>
+#include <SpiNor.hpp>
+#include <array>
+#include <cstdint>
+#include <optional>
+
+namespace m::tsts {
+
+// Time of Iterations reads of Buf_Size bytes per read mode,
+// nullopt if the mode is not supported by the SPI backend or skipped.
+// Quad is measured only with quad set, it writes the non-volatile QE bit.
+template <typename TimeUnit>
+struct FlashReadBenchResult {
+  std::optional<TimeUnit> normal;
+  std::optional<TimeUnit> fast;
+  std::optional<TimeUnit> dual;
+  std::optional<TimeUnit> quad;
+};
+
+template <uint32_t Buf_Size, uint32_t Iterations, typename TimeUnit,
+          typename FlashTimeUnit, std::size_t Queue_Size>
+FlashReadBenchResult<TimeUnit> flashReadBench(
+    ifc::ITime<TimeUnit>& time,
+    ic::SpiNor<FlashTimeUnit, Queue_Size>& flash, bool quad = false) {
+  using ReadMode =
+      typename ic::SpiNor<FlashTimeUnit, Queue_Size>::ReadMode;
+
+  std::array<uint8_t, Buf_Size> buf;
+  auto prev_mode = flash.getReadMode();
+
+  auto measure = [&](ReadMode mode) -> std::optional<TimeUnit> {
+    if (!flash.setReadMode(mode)) return std::nullopt;
+
+    auto start = time.getTick();
+    for (uint32_t i = 0; i < Iterations; ++i) {
+      if (!flash.read(i * Buf_Size % flash.size(), buf)) return std::nullopt;
+    }
+    return time.getDiff(start);
+  };
+
+  FlashReadBenchResult<TimeUnit> result;
+  result.normal = measure(ReadMode::Normal);
+  result.fast = measure(ReadMode::Fast);
+  result.dual = measure(ReadMode::Dual);
+  if (quad) result.quad = measure(ReadMode::Quad);
+
+  flash.setReadMode(prev_mode);
+
+  return result;
+}
+}  // namespace m::tsts
+
+#endif  // FLASHREADBENCH_H
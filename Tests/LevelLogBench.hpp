@@ -0,0 +1,66 @@
+/**
+ * This file is part of m library.
+ *
+ * m library is free software: you can redistribute it and/or modify
+ * it under the terms of the MIT License. See the LICENSE file in the
+ * project root for more information.
+ *
+ * Copyright (c) 2025 Max Melekesov <max.melekesov@gmail.com>
+ */
+
+#ifndef LEVELLOGBENCH_H
+#define LEVELLOGBENCH_H
+
+#include <ILog.hpp>
+#include <ITime.hpp>
+#include <LevelLog.hpp>
+#include <cstdint>
+
+namespace m::tsts {
+
+template <typename TimeUnit>
+struct LevelLogBenchResult {
+  TimeUnit compiled_out;      // Site below Compiled_Level
+  TimeUnit runtime_filtered;  // Site below runtime threshold
+  TimeUnit enabled;           // Site passed to sink
+};
+
+// Time of Iterations calls for each case, sink sees only the enabled ones
+template <uint32_t Iterations, typename TimeUnit>
+LevelLogBenchResult<TimeUnit> levelLogBench(ifc::ITime<TimeUnit>& time,
+                                            ifc::ILog& sink) {
+  LevelLog<LogLevel::Info, true> log(sink);
+  log.setThreshold(LogLevel::Warning);
+
+  // Text is built on every call unless the site is discarded
+  volatile uint32_t value = 0;
+  auto text = [&]() -> std::string_view {
+    value = value + 1;
+    return "bench";
+  };
+
+  LevelLogBenchResult<TimeUnit> result;
+
+  auto start = time.getTick();
+  for (uint32_t i = 0; i < Iterations; ++i) {
+    log.template add<LogLevel::Debug>(text);
+  }
+  result.compiled_out = time.getDiff(start);
+
+  start = time.getTick();
+  for (uint32_t i = 0; i < Iterations; ++i) {
+    log.template add<LogLevel::Info>(text);
+  }
+  result.runtime_filtered = time.getDiff(start);
+
+  start = time.getTick();
+  for (uint32_t i = 0; i < Iterations; ++i) {
+    log.template add<LogLevel::Error>(text);
+  }
+  result.enabled = time.getDiff(start);
+
+  return result;
+}
+}  // namespace m::tsts
+
+#endif  // LEVELLOGBENCH_H
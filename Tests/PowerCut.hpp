@@ -0,0 +1,106 @@
+/**
+ * This file is part of m library.
+ *
+ * m library is free software: you can redistribute it and/or modify
+ * it under the terms of the MIT License. See the LICENSE file in the
+ * project root for more information.
+ *
+ * Copyright (c) 2025 Max Melekesov <max.melekesov@gmail.com>
+ */
+
+#ifndef POWERCUT_H
+#define POWERCUT_H
+
+#include <IFlashMemory.hpp>
+#include <IMemory.hpp>
+#include <algorithm>
+#include <cstdint>
+#include <optional>
+#include <span>
+
+namespace m::tsts {
+
+// Flash that loses power once a budget is spent, every programmed byte
+// and every erase cost one. The write crossing the budget programs its
+// head, leaves the next skip bytes erased and programs the rest, as an
+// interrupted program may land any subset of bytes. After that writes and
+// erases fail until restore().
+class PowerCutFlash : public ifc::IFlashMemory {
+ public:
+  PowerCutFlash(ifc::IFlashMemory& flash) : flash_(flash) {}
+
+  void cut(std::size_t budget, std::size_t skip = 0) {
+    budget_ = budget;
+    skip_ = skip;
+  }
+  void restore() { budget_.reset(); }
+
+  std::size_t size() override { return flash_.size(); }
+
+  bool erase(std::size_t addr, uint32_t size) override {
+    if (budget_) {
+      if (budget_.value() == 0) return false;
+      --budget_.value();
+    }
+    return flash_.erase(addr, size);
+  }
+
+  bool write(std::size_t addr, std::span<uint8_t const> data) override {
+    if (budget_) {
+      auto size = std::min(data.size(), budget_.value());
+      budget_.value() -= size;
+      if (size != data.size()) {
+        if (size != 0) flash_.write(addr, data.first(size));
+        auto tail = std::min(data.size(), size + skip_);
+        if (tail != data.size()) {
+          flash_.write(addr + tail, data.subspan(tail));
+        }
+        return false;
+      }
+    }
+    return flash_.write(addr, data);
+  }
+
+  bool read(std::size_t addr, std::span<uint8_t> data) override {
+    return flash_.read(addr, data);
+  }
+
+ private:
+  ifc::IFlashMemory& flash_;
+  std::optional<std::size_t> budget_;
+  std::size_t skip_ = 0;
+};
+
+// Same for a memory without erase, budget is in written bytes
+class PowerCutMemory : public ifc::IMemory {
+ public:
+  PowerCutMemory(ifc::IMemory& mem) : mem_(mem) {}
+
+  void cut(std::size_t budget) { budget_ = budget; }
+  void restore() { budget_.reset(); }
+
+  std::size_t size() override { return mem_.size(); }
+
+  bool write(std::size_t addr, std::span<uint8_t const> data) override {
+    if (budget_) {
+      auto size = std::min(data.size(), budget_.value());
+      budget_.value() -= size;
+      if (size != data.size()) {
+        if (size != 0) mem_.write(addr, data.first(size));
+        return false;
+      }
+    }
+    return mem_.write(addr, data);
+  }
+
+  bool read(std::size_t addr, std::span<uint8_t> data) override {
+    return mem_.read(addr, data);
+  }
+
+ private:
+  ifc::IMemory& mem_;
+  std::optional<std::size_t> budget_;
+};
+}  // namespace m::tsts
+
+#endif  // POWERCUT_H
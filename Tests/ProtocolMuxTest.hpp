@@ -0,0 +1,129 @@
+/**
+ * This file is part of m library.
+ *
+ * m library is free software: you can redistribute it and/or modify
+ * it under the terms of the MIT License. See the LICENSE file in the
+ * project root for more information.
+ *
+ * Copyright (c) 2025 Max Melekesov <max.melekesov@gmail.com>
+ */
+
+#ifndef PROTOCOLMUXTEST_H
+#define PROTOCOLMUXTEST_H
+
+#include <DataLinkAsync.hpp>
+#include <IIO_Async.hpp>
+#include <ITime.hpp>
+#include <ModbusRtuProtocol.hpp>
+#include <ProtocolMux.hpp>
+#include <Us.hpp>
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <utility>
+
+namespace m::tsts {
+
+// Host only. Ports Modbus RTU slaves over DataLinkAsync and fake UARTs
+// share one ProtocolMux. Requests land on the ports in turn, at a varying
+// phase of the weighted schedule. Returns the worst latency of each port,
+// in handle() calls from the request arriving to the response starting.
+// With the frame gap used here, 2 calls is the minimum.
+template <std::size_t Ports, uint32_t Requests>
+std::array<uint32_t, Ports> protocolMuxLatencyTest(
+    typename ProtocolMux<Us<uint32_t>, Ports>::Settings settings,
+    std::array<uint8_t, Ports> weights) {
+  using type = Us<uint32_t>;
+
+  class Time : public ifc::ITime<type> {
+   public:
+    void delay(type) override {}
+    type getTick() override { return type{++tick_}; }
+    type getDiff(type value) override { return type{tick_} - value; }
+
+   private:
+    uint32_t tick_ = 0;
+  };
+
+  class Uart : public ifc::IIO_Async {
+   public:
+    std::span<uint8_t> rx;
+    uint32_t rx_bytes = 0;
+    bool written = false;
+
+    uint32_t bytesToWrite() override { return 0; }
+    bool writeAsync(std::span<uint8_t const>) override {
+      written = true;
+      return true;
+    }
+    bool abortWrite() override { return true; }
+    bool writeDone() override { return true; }
+
+    uint32_t bytesAvailable() override { return rx_bytes; }
+    bool readAsync(std::span<uint8_t> data) override {
+      rx = data;
+      rx_bytes = 0;
+      return true;
+    }
+    bool abortRead() override {
+      rx = {};
+      return true;
+    }
+    bool readDone() override { return true; }
+
+    uint32_t getBaudrate() override { return 115'200; }
+    bool error() override { return false; }
+  };
+
+  struct Node {
+    std::array<uint8_t, 256> rx_buf;
+    std::array<uint8_t, 256> tx_buf;
+    Uart uart;
+    DataLinkAsync<type> link;
+    ModbusRtuProtocol<type> protocol;
+
+    Node(Time& time)
+        : link(time, uart, {type{0}}),
+          protocol(link, time, {type{0}}, rx_buf, tx_buf) {
+      protocol.setAddress(1);
+    }
+  };
+
+  Time time;
+  auto nodes = [&]<std::size_t... Is>(std::index_sequence<Is...>) {
+    return std::array<Node, Ports>{((void)Is, Node(time))...};
+  }(std::make_index_sequence<Ports>{});
+
+  ProtocolMux<type, Ports> mux(time, settings);
+  for (std::size_t i = 0; i < Ports; ++i) {
+    mux.addPort(nodes[i].protocol, weights[i]);
+  }
+
+  // Read one holding register at 0 from slave 1
+  constexpr std::array<uint8_t, 8> Request{0x01, 0x03, 0x00, 0x00,
+                                           0x00, 0x01, 0x84, 0x0A};
+
+  std::array<uint32_t, Ports> worst{};
+  for (uint32_t r = 0; r < Requests; ++r) {
+    auto& node = nodes[r % Ports];
+    for (uint32_t i = 0; node.uart.rx.empty() || i < r % 7; ++i) {
+      mux.handle();
+    }
+
+    std::ranges::copy(Request, node.uart.rx.begin());
+    node.uart.rx_bytes = Request.size();
+    node.uart.written = false;
+
+    uint32_t calls = 0;
+    while (!node.uart.written && calls < 1'000) {
+      mux.handle();
+      ++calls;
+    }
+    worst[r % Ports] = std::max(worst[r % Ports], calls);
+  }
+
+  return worst;
+}
+}  // namespace m::tsts
+
+#endif  // PROTOCOLMUXTEST_H
@@ -0,0 +1,113 @@
+/**
+ * This file is part of m library.
+ *
+ * m library is free software: you can redistribute it and/or modify
+ * it under the terms of the MIT License. See the LICENSE file in the
+ * project root for more information.
+ *
+ * Copyright (c) 2025 Max Melekesov <max.melekesov@gmail.com>
+ */
+
+#ifndef RINGERRORTRACERTEST_H
+#define RINGERRORTRACERTEST_H
+
+#include <ITime.hpp>
+#include <Ms.hpp>
+#include <RingErrorTracer.hpp>
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <thread>
+
+namespace m::tsts {
+
+// Host only. First a single context checks folding, overwriting of the
+// oldest entries and clear(). Then threads stand in for ISRs: producer id
+// adds id * Errors_Per_Producer + seq twice in a row while the main thread
+// reads entries. Every entry read must be whole: a known value, count of
+// 1 or 2, first <= last, and the values of one producer in order.
+template <uint32_t Producers_Num, uint32_t Errors_Per_Producer>
+bool ringErrorTracerTest() {
+  using type = Ms<uint32_t>;
+
+  class Time : public ifc::ITime<type> {
+   public:
+    void delay(type) override {}
+    type getTick() override { return type{tick_++}; }
+    type getDiff(type value) override { return type{tick_} - value; }
+
+   private:
+    std::atomic<uint32_t> tick_{0};
+  };
+
+  Time time;
+  {
+    RingErrorTracer<uint32_t, 4, type> tracer(time);
+    for (uint32_t v : {1, 1, 1, 2, 3, 3, 4, 5, 5, 5, 5}) tracer.add(v);
+
+    using Entry = decltype(tracer)::Entry;
+    std::array<Entry, 8> entries;
+    auto size = tracer.getEntries(entries);
+    constexpr std::array<uint32_t, 4> Values{2, 3, 4, 5};
+    constexpr std::array<uint32_t, 4> Counts{1, 2, 1, 4};
+    if (size != Values.size()) return false;
+    for (std::size_t i = 0; i < size; ++i) {
+      if (entries[i].value != Values[i] || entries[i].count != Counts[i] ||
+          entries[i].last - entries[i].first != type{Counts[i] - 1}) {
+        return false;
+      }
+    }
+
+    auto trace = tracer.getTrace();
+    if (!std::ranges::equal(trace, Values)) return false;
+
+    tracer.clear();
+    if (!tracer.getTrace().empty()) return false;
+    tracer.add(7);
+    if (tracer.getTrace().size() != 1 || tracer.getTrace()[0] != 7) {
+      return false;
+    }
+  }
+
+  RingErrorTracer<uint32_t, 16, type> tracer(time);
+  using Entry = decltype(tracer)::Entry;
+  std::atomic<uint32_t> running{Producers_Num};
+
+  std::array<std::thread, Producers_Num> producers;
+  for (uint32_t id = 0; id < Producers_Num; ++id) {
+    producers[id] = std::thread([&tracer, &running, id]() {
+      for (uint32_t seq = 0; seq < Errors_Per_Producer; ++seq) {
+        tracer.add(id * Errors_Per_Producer + seq);
+        tracer.add(id * Errors_Per_Producer + seq);
+        if (seq % 64 == 0) std::this_thread::yield();
+      }
+      --running;
+    });
+  }
+
+  bool ok = true;
+  while (running && ok) {
+    std::array<Entry, 16> entries;
+    auto size = tracer.getEntries(entries);
+
+    std::array<int64_t, Producers_Num> last;
+    last.fill(-1);
+    for (std::size_t i = 0; i < size; ++i) {
+      auto& entry = entries[i];
+      auto id = entry.value / Errors_Per_Producer;
+      if (id >= Producers_Num || entry.count < 1 || entry.count > 2 ||
+          entry.first > entry.last || entry.value <= last[id]) {
+        ok = false;
+        break;
+      }
+      last[id] = entry.value;
+    }
+  }
+  for (auto& t : producers) t.join();
+
+  return ok && tracer.getTrace().size() == 16;
+}
+}  // namespace m::tsts
+
+#endif  // RINGERRORTRACERTEST_H
@@ -0,0 +1,86 @@
+/**
+ * This file is part of m library.
+ *
+ * m library is free software: you can redistribute it and/or modify
+ * it under the terms of the MIT License. See the LICENSE file in the
+ * project root for more information.
+ *
+ * Copyright (c) 2025 Max Melekesov <max.melekesov@gmail.com>
+ */
+
+#ifndef SECTORCACHETEST_H
+#define SECTORCACHETEST_H
+
+#include <IMemory.hpp>
+#include <MemoryPart.hpp>
+#include <SectorCache.hpp>
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstdlib>
+
+namespace m::tsts {
+
+// Iterations random writes and reads through a SectorCache on a
+// MemoryPart of the first Part_Size bytes of mem, which ends inside a
+// sector. Every read and, after each flush(), the part itself must match
+// the data written. Accesses past the part must be refused and the rest
+// of the last sector must not change.
+template <std::size_t Sectors_Num, std::size_t Sector_Size,
+          std::size_t Part_Size, uint32_t Iterations>
+bool sectorCacheTest(ifc::IMemory& mem) {
+  static_assert(Part_Size % Sector_Size != 0, "Part must end in a sector");
+  constexpr std::size_t Guard_Size = Sector_Size - Part_Size % Sector_Size;
+
+  std::srand(0x12'34'56'78);
+  if (mem.size() < Part_Size + Guard_Size) return false;
+
+  std::array<uint8_t, Part_Size> expected;
+  std::array<uint8_t, Guard_Size> guard;
+  for (auto& v : expected) v = std::rand() % 255;
+  for (auto& v : guard) v = std::rand() % 255;
+  if (!mem.write(0, expected) || !mem.write(Part_Size, guard)) return false;
+
+  MemoryPart part(mem, 0, Part_Size);
+  SectorCache<Sectors_Num, Sector_Size> cache(part);
+
+  std::array<uint8_t, 1> byte;
+  if (cache.write(Part_Size - 1, std::array<uint8_t, 2>{}) ||
+      cache.read(Part_Size, byte)) {
+    return false;
+  }
+
+  auto check = [&](std::size_t addr, ifc::IMemory& from) {
+    std::array<uint8_t, Sector_Size> data;
+    auto size = std::min(data.size(), Part_Size - addr);
+    auto span = std::span(data).first(size);
+    return from.read(addr, span) &&
+           std::ranges::equal(span, std::span(expected).subspan(addr, size));
+  };
+
+  for (uint32_t i = 0; i < Iterations; ++i) {
+    std::array<uint8_t, Sector_Size + 1> data;
+    auto addr = std::rand() % Part_Size;
+    auto size = 1 + std::rand() % std::min(data.size(), Part_Size - addr);
+    auto span = std::span(data).first(size);
+    for (auto& v : span) v = std::rand() % 255;
+
+    if (!cache.write(addr, span)) return false;
+    std::ranges::copy(span, expected.begin() + addr);
+    if (!check(std::rand() % Part_Size, cache)) return false;
+
+    if (i % 8 == 0) {
+      if (!cache.flush()) return false;
+      for (std::size_t a = 0; a < Part_Size; a += Sector_Size) {
+        if (!check(a, part)) return false;
+      }
+    }
+  }
+
+  std::array<uint8_t, Guard_Size> back;
+  return cache.flush() && mem.read(Part_Size, back) &&
+         std::ranges::equal(back, guard);
+}
+}  // namespace m::tsts
+
+#endif  // SECTORCACHETEST_H
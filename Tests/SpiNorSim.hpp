@@ -0,0 +1,427 @@
+/**
+ * This file is part of m library.
+ *
+ * m library is free software: you can redistribute it and/or modify
+ * it under the terms of the MIT License. See the LICENSE file in the
+ * project root for more information.
+ *
+ * Copyright (c) 2025 Max Melekesov <max.melekesov@gmail.com>
+ */
+
+#ifndef SPINORSIM_H
+#define SPINORSIM_H
+
+#include <IIO_Sync.hpp>
+#include <IPin.hpp>
+#include <ITime.hpp>
+#include <Ms.hpp>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace m::tsts {
+
+// ##################################################
+// Usage Example:
+// m::tsts::SpiNorSim<uint32_t> sim(16 * 1024 * 1024);
+// sim.open("flash.bin");
+// static std::array<uint8_t, 4'096> scratch;
+// m::ic::PY25Q128HA<uint32_t> flash(sim, sim, sim, scratch);
+//
+// Host model of a SPI NOR chip with the command set of SpiNor, including
+// JEDEC ID and SFDP. Memory is a mmap of a file (kept between runs) or
+// anonymous. Program only clears bits, erase sets blocks to 0xFF.
+// Time is virtual: SPI transfers advance it by their clocks, every
+// getTick() by 1 us, so busy polling is deterministic and fast.
+// CS is selected with write(1), as the driver does.
+// ##################################################
+
+template <typename TimeUnit>
+class SpiNorSim : public ifc::IIO_Sync<Ms<TimeUnit>>,
+                  public ifc::mcu::IPin,
+                  public ifc::ITime<Ms<TimeUnit>> {
+ public:
+  using type = Ms<TimeUnit>;
+
+  struct Timing {
+    uint32_t page_program_us = 400;
+    uint32_t erase_4k_us = 45'000;
+    uint32_t erase_32k_us = 150'000;
+    uint32_t erase_64k_us = 250'000;
+    uint32_t chip_erase_us = 40'000'000;
+    uint32_t status_write_us = 5'000;
+    // tRS, a suspend sooner after resume throws away the progress made
+    uint32_t resume_to_suspend_us = 64;
+  };
+
+  SpiNorSim(std::size_t size, uint32_t baudrate = 50'000'000,
+            Timing timing = {}, uint32_t jedec_id = 0x85'20'18)
+      : size_(size),
+        baudrate_(baudrate),
+        timing_(timing),
+        jedec_id_(jedec_id),
+        erase_counts_(size / 4'096) {
+    makeSfdp();
+  }
+
+  ~SpiNorSim() { close(); }
+
+  SpiNorSim(SpiNorSim const&) = delete;
+  SpiNorSim& operator=(SpiNorSim const&) = delete;
+
+  // Maps the file, a new file is filled with 0xFF. Nullptr - anonymous.
+  bool open(char const* path = nullptr) {
+    close();
+
+    if (path == nullptr) {
+      auto mem = mmap(nullptr, size_, PROT_READ | PROT_WRITE,
+                      MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+      if (mem == MAP_FAILED) return false;
+      mem_ = static_cast<uint8_t*>(mem);
+      std::fill_n(mem_, size_, 0xFF);
+      return true;
+    }
+
+    fd_ = ::open(path, O_RDWR | O_CREAT, 0644);
+    if (fd_ < 0) return false;
+
+    struct stat st;
+    if (fstat(fd_, &st) != 0) return false;
+    bool fresh = static_cast<std::size_t>(st.st_size) < size_;
+    if (fresh && ftruncate(fd_, size_) != 0) return false;
+
+    auto mem = mmap(nullptr, size_, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0);
+    if (mem == MAP_FAILED) return false;
+    mem_ = static_cast<uint8_t*>(mem);
+    if (fresh) std::fill_n(mem_ + st.st_size, size_ - st.st_size, 0xFF);
+
+    return true;
+  }
+
+  void close() {
+    if (mem_ != nullptr) munmap(mem_, size_);
+    if (fd_ >= 0) ::close(fd_);
+    mem_ = nullptr;
+    fd_ = -1;
+  }
+
+  std::span<uint8_t> memory() { return std::span(mem_, mem_ ? size_ : 0); }
+
+  // Erases of every 4K sector, a block erase counts for all its sectors
+  std::span<uint32_t const> getEraseCounts() { return erase_counts_; }
+
+  uint64_t getProgrammedBytes() { return programmed_; }
+  uint64_t getReadBytes() { return read_; }
+  uint64_t getClocks() { return clocks_; }
+  uint64_t getTimeUs() { return ns_ / 1'000; }
+
+  // Program that tried to set a bit from 0 to 1
+  uint32_t getViolations() { return violations_; }
+
+  // Commands while busy, without write enable or malformed
+  uint32_t getErrors() { return errors_; }
+
+  void setSfdp(bool enabled) { sfdp_enabled_ = enabled; }
+  void setMultiLine(bool enabled) { multi_line_ = enabled; }
+
+  // IIO_Sync
+
+  bool write(std::span<uint8_t const> data, type) override {
+    if (!selected_) return false;
+    advance(data.size() * 8 / lines_);
+    tx_.insert(tx_.end(), data.begin(), data.end());
+    return true;
+  }
+
+  bool read(std::span<uint8_t> data, type) override {
+    if (!selected_ || tx_.empty()) return false;
+    advance(data.size() * 8 / lines_);
+
+    switch (tx_[0]) {
+      case 0x05:
+        std::ranges::fill(data, (busy() ? 0x01 : 0) | (wel_ ? 0x02 : 0) |
+                                    (status_ & 0xFC));
+        return true;
+      case 0x35:
+        std::ranges::fill(data, status_1_ | (suspended_ ? 0x80 : 0));
+        return true;
+      case 0x9F:
+        for (std::size_t i = 0; i < data.size(); ++i) {
+          data[i] = i < 3 ? jedec_id_ >> (16 - 8 * i) : 0;
+        }
+        return true;
+      case 0x5A: {
+        if (tx_.size() != 5 || !sfdp_enabled_) return error();
+        uint32_t addr = (tx_[1] << 16) | (tx_[2] << 8) | tx_[3];
+        for (auto& v : data) {
+          v = addr + rd_offset_ < sfdp_.size() ? sfdp_[addr + rd_offset_] : 0;
+          ++rd_offset_;
+        }
+        return true;
+      }
+      case 0x03:
+      case 0x0B:
+      case 0x3B:
+      case 0x6B: {
+        auto dummy = tx_[0] == 0x03 ? 0 : 1;
+        if (busy() || tx_.size() != 1 + addrBytes() + dummy) return error();
+        uint8_t lines = tx_[0] == 0x3B ? 2 : tx_[0] == 0x6B ? 4 : 1;
+        if (lines != lines_ || (lines == 4 && !(status_1_ & 0x02))) {
+          return error();
+        }
+        for (auto& v : data) v = mem_[(address() + rd_offset_++) % size_];
+        read_ += data.size();
+        return true;
+      }
+    }
+    return error();
+  }
+
+  uint32_t getBaudrate() override { return baudrate_; }
+
+  bool setDataLines(uint8_t lines) override {
+    if (lines != 1 && !multi_line_) return false;
+    if (lines != 1 && lines != 2 && lines != 4) return false;
+    lines_ = lines;
+    return true;
+  }
+
+  // IPin, chip select
+
+  void write(bool state) override {
+    if (state) {
+      selected_ = true;
+      tx_.clear();
+      rd_offset_ = 0;
+      return;
+    }
+    if (!selected_) return;
+    selected_ = false;
+    if (!tx_.empty()) execute();
+  }
+
+  bool read() const override { return selected_; }
+  void toggle() override { write(!selected_); }
+
+  // ITime
+
+  void delay(type value) override {
+    ns_ += static_cast<uint64_t>(value.value()) * 1'000'000;
+  }
+
+  type getTick() override {
+    ns_ += 1'000;
+    return type{static_cast<TimeUnit>(ns_ / 1'000'000)};
+  }
+
+  type getDiff(type value) override { return getTick() - value; }
+
+ private:
+  std::size_t const size_;
+  uint32_t const baudrate_;
+  Timing const timing_;
+  uint32_t const jedec_id_;
+
+  uint8_t* mem_ = nullptr;
+  int fd_ = -1;
+
+  std::vector<uint8_t> tx_;
+  std::size_t rd_offset_ = 0;
+  bool selected_ = false;
+  uint8_t lines_ = 1;
+  bool multi_line_ = true;
+
+  bool wel_ = false;
+  bool addr4_ = false;
+  uint8_t status_ = 0;
+  uint8_t status_1_ = 0;
+  bool suspended_ = false;
+  uint64_t busy_until_ = 0;
+  uint64_t suspended_left_ = 0;
+  uint64_t resumed_at_ = 0;
+
+  std::vector<uint8_t> sfdp_;
+  bool sfdp_enabled_ = true;
+
+  uint64_t ns_ = 0;
+  uint64_t clocks_ = 0;
+  uint64_t programmed_ = 0;
+  uint64_t read_ = 0;
+  uint32_t violations_ = 0;
+  uint32_t errors_ = 0;
+  std::vector<uint32_t> erase_counts_;
+
+  void advance(uint64_t clocks) {
+    clocks_ += clocks;
+    ns_ += clocks * 1'000'000'000 / baudrate_;
+  }
+
+  bool busy() { return ns_ < busy_until_; }
+
+  bool error() {
+    ++errors_;
+    return false;
+  }
+
+  std::size_t addrBytes() { return addr4_ ? 4 : 3; }
+
+  uint32_t address() {
+    uint32_t addr = 0;
+    for (std::size_t i = 1; i <= addrBytes(); ++i) addr = addr << 8 | tx_[i];
+    return addr;
+  }
+
+  void execute() {
+    auto cmd = tx_[0];
+    switch (cmd) {
+      case 0x03:
+      case 0x05:
+      case 0x0B:
+      case 0x35:
+      case 0x3B:
+      case 0x5A:
+      case 0x6B:
+      case 0x9F:
+        return;
+      case 0x75:
+        if (busy() && !suspended_) {
+          suspended_ = true;
+          auto trs = timing_.resume_to_suspend_us * 1'000ull;
+          auto from = ns_ - resumed_at_ < trs ? resumed_at_ : ns_;
+          suspended_left_ = busy_until_ - from;
+          busy_until_ = ns_;
+        }
+        return;
+      case 0x7A:
+        if (suspended_) {
+          suspended_ = false;
+          busy_until_ = ns_ + suspended_left_;
+          resumed_at_ = ns_;
+        }
+        return;
+    }
+
+    if (busy() || suspended_) {
+      error();
+      return;
+    }
+
+    switch (cmd) {
+      case 0x06:
+        wel_ = true;
+        return;
+      case 0x04:
+        wel_ = false;
+        return;
+      case 0xB7:
+        addr4_ = true;
+        return;
+      case 0xE9:
+        addr4_ = false;
+        return;
+    }
+
+    if (!wel_) {
+      error();
+      return;
+    }
+    wel_ = false;
+
+    switch (cmd) {
+      case 0x01:
+        if (tx_.size() > 1) status_ = tx_[1] & 0xFC;
+        if (tx_.size() > 2) status_1_ = tx_[2] & 0x7F;
+        busy_until_ = ns_ + timing_.status_write_us * 1'000ull;
+        return;
+      case 0x31:
+        if (tx_.size() > 1) status_1_ = tx_[1] & 0x7F;
+        busy_until_ = ns_ + timing_.status_write_us * 1'000ull;
+        return;
+      case 0x02:
+        program();
+        return;
+      case 0x20:
+        erase(4'096, timing_.erase_4k_us);
+        return;
+      case 0x52:
+        erase(32'768, timing_.erase_32k_us);
+        return;
+      case 0xD8:
+        erase(65'536, timing_.erase_64k_us);
+        return;
+      case 0x60:
+      case 0xC7:
+        tx_.resize(1 + addrBytes(), 0);
+        erase(size_, timing_.chip_erase_us);
+        return;
+    }
+    error();
+  }
+
+  // Data wraps inside the 256 byte page, as on the real chip
+  void program() {
+    if (tx_.size() <= 1 + addrBytes()) {
+      error();
+      return;
+    }
+    auto addr = address() % size_;
+    auto page = addr & ~uint32_t{0xFF};
+    for (std::size_t i = 1 + addrBytes(); i < tx_.size(); ++i) {
+      auto& cell = mem_[page + (addr + i - 1 - addrBytes()) % 256];
+      if ((cell & tx_[i]) != tx_[i]) ++violations_;
+      cell &= tx_[i];
+    }
+    programmed_ += tx_.size() - 1 - addrBytes();
+    busy_until_ = ns_ + timing_.page_program_us * 1'000ull;
+  }
+
+  void erase(std::size_t size, uint32_t time_us) {
+    if (tx_.size() != 1 + addrBytes()) {
+      error();
+      return;
+    }
+    auto addr = address() % size_ / size * size;
+    std::fill_n(mem_ + addr, size, 0xFF);
+    for (auto sector = addr / 4'096; sector < (addr + size) / 4'096; ++sector) {
+      ++erase_counts_[sector];
+    }
+    busy_until_ = ns_ + time_us * 1'000ull;
+  }
+
+  // JESD216 header and basic table: 4K/32K/64K erase, 1-1-2 and 1-1-4
+  // reads with 8 dummy clocks, QE in status 2 via 0x31, suspend 0x75/0x7A
+  void makeSfdp() {
+    std::array<uint32_t, 16> dw{};
+    dw[0] = 0x01 | (0x20 << 8) | (1 << 16) | (1 << 22);
+    if (size_ > 16 * 1024 * 1024) dw[0] |= 1 << 17;
+    dw[1] = static_cast<uint32_t>(size_ * 8 - 1);
+    dw[2] = 0x6B'08'00'00;
+    dw[3] = 0x00'00'3B'08;
+    dw[7] = 0x52'0F'20'0C;
+    dw[8] = 0x00'00'D8'10;
+    auto trs = std::clamp<uint32_t>(timing_.resume_to_suspend_us / 64, 1, 16);
+    dw[11] = ((trs - 1) << 20) | ((trs - 1) << 9);
+    dw[12] = 0x75'7A'75'7A;
+    dw[14] = 6 << 20;
+
+    sfdp_.assign(0x30 + dw.size() * 4, 0xFF);
+    auto put = [&](std::size_t pos, uint32_t value) {
+      for (std::size_t i = 0; i < 4; ++i) sfdp_[pos + i] = value >> (8 * i);
+    };
+    put(0x00, 0x50'44'46'53);
+    put(0x04, 0xFF'00'01'06);
+    put(0x08, 0x10'01'06'00);
+    put(0x0C, 0xFF'00'00'30);
+    for (std::size_t i = 0; i < dw.size(); ++i) put(0x30 + i * 4, dw[i]);
+  }
+};
+}  // namespace m::tsts
+
+#endif  // SPINORSIM_H
@@ -0,0 +1,104 @@
+/**
+ * This file is part of m library.
+ *
+ * m library is free software: you can redistribute it and/or modify
+ * it under the terms of the MIT License. See the LICENSE file in the
+ * project root for more information.
+ *
+ * Copyright (c) 2025 Max Melekesov <max.melekesov@gmail.com>
+ */
+
+#ifndef TIMESTAMPLOGTEST_H
+#define TIMESTAMPLOGTEST_H
+
+#include <IIO_Async.hpp>
+#include <IIO_AsyncLog.hpp>
+#include <ITime.hpp>
+#include <Ms.hpp>
+#include <TimestampLog.hpp>
+#include <array>
+#include <cstdint>
+#include <string_view>
+
+namespace m::tsts {
+
+// Host only. Records of 0..79 characters go TimestampLog ->
+// IIO_AsyncLog (Binary framing, default 63 byte lines) ->
+// TimestampLogDecoder while the 32 bit tick wraps. Every record must
+// come back whole with its tick and the text cut to Text_Max.
+inline bool timestampLogTest() {
+  class Sink : public ifc::IIO_Async {
+   public:
+    std::array<uint8_t, 2'048> out;
+    std::size_t size = 0;
+
+    uint32_t bytesToWrite() override { return 0; }
+    bool writeAsync(std::span<uint8_t const> data) override {
+      if (size + data.size() > out.size()) return false;
+      for (auto c : data) out[size++] = c;
+      return true;
+    }
+    bool abortWrite() override { return true; }
+    bool writeDone() override { return true; }
+
+    uint32_t bytesAvailable() override { return 0; }
+    bool readAsync(std::span<uint8_t>) override { return false; }
+    bool abortRead() override { return true; }
+    bool readDone() override { return true; }
+
+    uint32_t getBaudrate() override { return 0; }
+    bool error() override { return false; }
+  };
+
+  class Time : public ifc::ITime<Ms<uint32_t>> {
+   public:
+    type tick{0xFF'FF'FF'00};
+
+    void delay(type) override {}
+    type getTick() override { return tick; }
+    type getDiff(type value) override { return tick - value; }
+  };
+
+  using Log = TimestampLog<Ms<uint32_t>, 63, 4>;
+  constexpr uint32_t Records = 40;
+
+  Sink sink;
+  Time time;
+  IIO_AsyncLog<1'024, 63, LogProducers::Single, LogOverflow::DropNewest,
+               LogFraming::Binary>
+      async_log(sink);
+  Log log(async_log, time);
+
+  std::array<char, 80> text;
+  for (std::size_t i = 0; i < text.size(); ++i) text[i] = 'a' + i % 26;
+
+  for (uint32_t i = 0; i < Records; ++i) {
+    log.add(std::string_view(text.data(), i * 2));
+    time.tick += Ms<uint32_t>{i * 13};
+    if (i % 8 == 0) async_log.handle();
+  }
+  async_log.handle();
+  if (async_log.getDropped() != 0) return false;
+
+  TimestampLogDecoder<32> decoder;
+  auto data = std::span<uint8_t const>(sink.out.data(), sink.size);
+  uint64_t tick = 0xFF'FF'FF'00;
+  for (uint32_t i = 0; i < Records; ++i) {
+    auto result = decoder.decode(data);
+    if (!result) return false;
+    auto [consumed, decoded_tick, decoded_text] = result.value();
+
+    auto size = std::min<std::size_t>(i * 2, Log::Text_Max);
+    if (decoded_tick != tick ||
+        decoded_text != std::string_view(text.data(), size)) {
+      return false;
+    }
+    tick += i * 13;
+    data = data.subspan(consumed);
+  }
+
+  return data.empty();
+}
+}  // namespace m::tsts
+
+#endif  // TIMESTAMPLOGTEST_H